@@ -1,11 +1,18 @@
 #pragma once
-#include <map>
 #include <vector>
-#include <unordered_map>
+#include <string>
 #include "order.h"
+#include "order_slots.h"
 #include "orderbook.h"
 
 namespace RLTrader {
+    // Where a replayed episode starts and how its latencies are drawn, enough to replay it again
+    struct EpisodeStart {
+        std::string filename;
+        size_t start_row = 0;
+        unsigned seed = 0;
+    };
+
     class BaseExchange {
     public:
         // Constructor
@@ -14,31 +21,87 @@ namespace RLTrader {
         // Resets the exchange's state
         virtual void reset() = 0;
 
-        // Advances to the next row in the data
-        virtual bool next_read(size_t& slot, OrderBook& book) = 0;
+        // Advances to the next row in the data and hands out its book, valid until done_read(slot);
+        // nullptr when the data ran out
+        virtual const OrderBook* next_book(size_t& slot) = 0;
+
+        // Advances to the next row in the data, copying its book
+        bool next_read(size_t& slot, OrderBook& book) {
+            const OrderBook* next = next_book(slot);
+            if (next == nullptr) return false;
+            book = *next;
+            return true;
+        }
 
         virtual void done_read(size_t slot) = 0;
 
-        // build order book from labeled data
-        virtual void toBook(const std::unordered_map<std::string, double>& lob, OrderBook &book) = 0;
+        // Time of the last book read in microseconds
+        [[nodiscard]] virtual long long getTimeStamp() const = 0;
 
         // fetches the current position from exchange
         virtual void fetchPosition(double& posAmount, double& avgPrice) = 0;
 
-        // Returns executed orders and clears them
-        virtual std::vector<Order> getFills() = 0;
+        // Swaps the executed orders into fills, whose old contents are dropped and whose buffer is kept for reuse
+        virtual void getFills(std::vector<Order>& fills) = 0;
 
         // Processes order cancellation
         virtual void cancelOrders() = 0;
 
-        [[nodiscard]] virtual const std::map<std::string, Order>& getBidOrders() const = 0;
+        [[nodiscard]] virtual const OrderSlots& getBidOrders() const = 0;
 
-        [[nodiscard]] virtual const std::map<std::string, Order>& getAskOrders() const = 0;
+        [[nodiscard]] virtual const OrderSlots& getAskOrders() const = 0;
 
         [[nodiscard]] virtual std::vector<Order> getUnackedOrders() const = 0;
 
-        virtual void quote(std::string order_id, OrderSide side, const double& price, const double& amount) = 0;
+        virtual void quote(OrderId order_id, OrderSide side, const double& price, const double& amount) = 0;
+
+        virtual void market(OrderId order_id, OrderSide side, const double& price, const double& amount) = 0;
+
+        // Changes the price and amount of a working quote in place, amount is the new order size including what it filled
+        virtual void amend(OrderId order_id, OrderSide side, const double& price, const double& amount) = 0;
+
+        // Cancels a single quote
+        virtual void cancel(OrderId order_id, OrderSide side) = 0;
+
+        // Sends requests as one batch: NEW orders (market orders when is_taker), AMEND and CANCELLED for a cancel.
+        // Venues that take batches send them in one message, the default sends them one by one.
+        virtual void submit(const std::vector<Order>& batch) {
+            for (const Order& order : batch) {
+                if (order.state == OrderState::CANCELLED) cancel(order.orderId, order.side);
+                else if (order.state == OrderState::AMEND) amend(order.orderId, order.side, order.price, order.amount);
+                else if (order.is_taker) market(order.orderId, order.side, order.price, order.amount);
+                else quote(order.orderId, order.side, order.price, order.amount);
+            }
+        }
+
+        // Whether a quote is resting or still on its way to the book
+        [[nodiscard]] virtual bool isLive(OrderId order_id, OrderSide side) const = 0;
+
+        // Whether no order is resting, pending or waiting to be reported
+        [[nodiscard]] virtual bool isIdle() const { return false; }
+
+        // Reads up to rows books without matching orders and hands out the books of the last history of them,
+        // oldest first, in books; returns the rows read. Only meant for when the exchange is idle, where
+        // matching has nothing to do.
+        virtual size_t advance(size_t rows, size_t history, std::vector<OrderBook>& books) {
+            books.clear();
+            size_t read = 0;
+            size_t slot = 0;
+            OrderBook book;
+            for (; read < rows && next_read(slot, book); ++read) {
+                if (read + history >= rows) books.push_back(book);
+                done_read(slot);
+            }
+            return read;
+        }
+
+        // Rows to read until the first one at or after timestamp, 0 when the venue cannot tell ahead
+        virtual size_t rowsUntil(long long /*timestamp*/) { return 0; }
+
+        // Episode the last reset started, false for venues that do not replay data
+        virtual bool getEpisode(EpisodeStart& /*episode*/) const { return false; }
 
-        virtual void market(std::string order_id, OrderSide side, const double& price, const double& amount) = 0;
+        // Precomputed market signals of the last book read, nullptr when they have to be built live
+        [[nodiscard]] virtual const double* marketSignals() const { return nullptr; }
     };
 }
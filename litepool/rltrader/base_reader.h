@@ -0,0 +1,57 @@
+#pragma once
+#include <random>
+#include "orderbook.h"
+
+namespace RLTrader {
+    class BaseReader {
+    public:
+        virtual ~BaseReader() = default;
+
+        // Rewinds to a random start row and reads the first row
+        virtual void reset() = 0;
+
+        // Rewinds to start_row and reads it
+        virtual void seek(size_t start_row) = 0;
+
+        // First row at or after timestamp, the last row if every row is earlier
+        [[nodiscard]] virtual size_t rowAt(long long timestamp) = 0;
+
+        // Checks whether another row is available
+        virtual bool hasNext() = 0;
+
+        // Moves to the next row
+        virtual void advance() = 0;
+
+        // Moves up to rows rows ahead, only the last one has to be read; returns the rows moved
+        virtual size_t skip(size_t rows) {
+            size_t moved = 0;
+            for (; moved < rows && hasNext(); ++moved) advance();
+            return moved;
+        }
+
+        // Row of the current data in its file
+        [[nodiscard]] virtual size_t getRow() const = 0;
+
+        // Timestamp of the current row
+        [[nodiscard]] virtual long long getTimeStamp() const = 0;
+
+        [[nodiscard]] virtual double getBestBidPrice() const = 0;
+
+        [[nodiscard]] virtual double getBestAskPrice() const = 0;
+
+        // Copies the current row into an order book, zeroing the levels past the file's depth
+        virtual void toBook(OrderBook& book) const = 0;
+
+        // Updates a book holding the previous row to the current row
+        virtual void patchBook(OrderBook& book) const { toBook(book); }
+
+    protected:
+        // Uniform random start row in [0, start_read]
+        static size_t randomStart(int start_read) {
+            std::random_device rd;
+            std::mt19937 gen(rd());
+            std::uniform_int_distribution<> distr(0, start_read);
+            return static_cast<size_t>(distr(gen));
+        }
+    };
+}
@@ -0,0 +1,161 @@
+#include "block_file.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <zlib.h>
+
+using namespace RLTrader;
+
+BlockFile::BlockFile(const std::string& filename) {
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Could not open block file " + filename);
+    }
+
+    struct stat st{};
+    if (::fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(BlockFileHeader)) {
+        ::close(fd);
+        throw std::runtime_error("Invalid block file " + filename);
+    }
+
+    mapping_size = static_cast<size_t>(st.st_size);
+    mapping = ::mmap(nullptr, mapping_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+
+    if (mapping == MAP_FAILED) {
+        mapping = nullptr;
+        throw std::runtime_error("Could not map block file " + filename);
+    }
+
+    header = static_cast<const BlockFileHeader*>(mapping);
+    index = reinterpret_cast<const BlockIndexEntry*>(static_cast<const char*>(mapping) + sizeof(BlockFileHeader));
+    size_t index_end = sizeof(BlockFileHeader) + header->num_blocks * sizeof(BlockIndexEntry);
+    bool valid = std::memcmp(header->magic, MAGIC, sizeof(MAGIC)) == 0
+                 && header->version == VERSION
+                 && header->block_rows > 0
+                 && index_end <= mapping_size
+                 && header->num_blocks == (header->rows + header->block_rows - 1) / header->block_rows;
+
+    for (size_t block = 0; valid && block < header->num_blocks; ++block) {
+        valid = index[block].offset >= index_end
+                && index[block].offset + index[block].compressed_size <= mapping_size;
+    }
+
+    if (!valid) {
+        ::munmap(mapping, mapping_size);
+        mapping = nullptr;
+        throw std::runtime_error("Corrupt block file " + filename);
+    }
+}
+
+BlockFile::~BlockFile() {
+    if (mapping != nullptr) {
+        ::munmap(mapping, mapping_size);
+    }
+}
+
+void BlockFile::decompress(size_t block, DecodedBlock& decoded) const {
+    if (block >= numBlocks()) {
+        throw std::out_of_range("Block out of range");
+    }
+
+    decoded.first_row = block * blockRows();
+    decoded.rows = std::min(blockRows(), rows() - decoded.first_row);
+    decoded.timestamps.resize(decoded.rows);
+    decoded.values.resize(decoded.rows * levels() * NUM_FIELDS);
+
+    // the block is the timestamp column followed by the value columns, inflate in one go
+    std::vector<unsigned char> raw(decoded.rows * sizeof(long long) + decoded.values.size() * sizeof(double));
+    auto raw_size = static_cast<uLongf>(raw.size());
+    const auto* source = static_cast<const unsigned char*>(mapping) + index[block].offset;
+    if (uncompress(raw.data(), &raw_size, source, static_cast<uLong>(index[block].compressed_size)) != Z_OK
+        || raw_size != raw.size()) {
+        throw std::runtime_error("Corrupt block " + std::to_string(block));
+    }
+
+    std::memcpy(decoded.timestamps.data(), raw.data(), decoded.rows * sizeof(long long));
+    std::memcpy(decoded.values.data(), raw.data() + decoded.rows * sizeof(long long),
+                decoded.values.size() * sizeof(double));
+}
+
+void BlockFile::write(const std::string& filename, size_t levels,
+                      const std::vector<long long>& timestamps,
+                      const std::vector<std::vector<double>>& columns,
+                      size_t block_rows) {
+    // the header stores block_rows in 32 bits and readers reject empty blocks
+    if (block_rows == 0 || block_rows > UINT32_MAX) {
+        throw std::runtime_error("Invalid block size " + std::to_string(block_rows));
+    }
+
+    if (columns.size() != levels * NUM_FIELDS) {
+        throw std::runtime_error("Column count does not match levels");
+    }
+
+    for (const auto& column : columns) {
+        if (column.size() != timestamps.size()) {
+            throw std::runtime_error("Column length does not match timestamps");
+        }
+    }
+
+    size_t num_rows = timestamps.size();
+    size_t num_blocks = (num_rows + block_rows - 1) / block_rows;
+    std::vector<BlockIndexEntry> block_index(num_blocks);
+    std::vector<std::vector<unsigned char>> blocks(num_blocks);
+    uint64_t offset = sizeof(BlockFileHeader) + num_blocks * sizeof(BlockIndexEntry);
+    std::vector<unsigned char> raw;
+
+    for (size_t block = 0; block < num_blocks; ++block) {
+        size_t first = block * block_rows;
+        size_t count = std::min(block_rows, num_rows - first);
+        raw.resize(count * sizeof(long long) + columns.size() * count * sizeof(double));
+        std::memcpy(raw.data(), timestamps.data() + first, count * sizeof(long long));
+        unsigned char* cursor = raw.data() + count * sizeof(long long);
+        for (const auto& column : columns) {
+            std::memcpy(cursor, column.data() + first, count * sizeof(double));
+            cursor += count * sizeof(double);
+        }
+
+        auto compressed_size = compressBound(static_cast<uLong>(raw.size()));
+        blocks[block].resize(compressed_size);
+        if (compress2(blocks[block].data(), &compressed_size, raw.data(),
+                      static_cast<uLong>(raw.size()), Z_DEFAULT_COMPRESSION) != Z_OK) {
+            throw std::runtime_error("Failed compressing block " + std::to_string(block));
+        }
+        blocks[block].resize(compressed_size);
+
+        block_index[block].offset = offset;
+        block_index[block].compressed_size = compressed_size;
+        block_index[block].first_timestamp = timestamps[first];
+        offset += compressed_size;
+    }
+
+    std::ofstream out(filename, std::ios::binary | std::ios::trunc);
+    if (!out.is_open()) {
+        throw std::runtime_error("Could not create block file " + filename);
+    }
+
+    BlockFileHeader header{};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.levels = static_cast<uint32_t>(levels);
+    header.rows = num_rows;
+    header.block_rows = static_cast<uint32_t>(block_rows);
+    header.num_blocks = static_cast<uint32_t>(num_blocks);
+
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(block_index.data()),
+              static_cast<std::streamsize>(block_index.size() * sizeof(BlockIndexEntry)));
+    for (const auto& block : blocks) {
+        out.write(reinterpret_cast<const char*>(block.data()), static_cast<std::streamsize>(block.size()));
+    }
+
+    if (!out.good()) {
+        throw std::runtime_error("Failed writing block file " + filename);
+    }
+}
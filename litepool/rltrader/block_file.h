@@ -0,0 +1,70 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "tick_file.h"
+
+namespace RLTrader {
+    // On-disk layout: header, block index, then deflate-compressed blocks.
+    // Every block holds block_rows rows (the last one fewer) in the columnar tick layout.
+    struct BlockFileHeader {
+        char magic[8];
+        uint32_t version;
+        uint32_t levels;
+        uint64_t rows;
+        uint32_t block_rows;
+        uint32_t num_blocks;
+    };
+
+    struct BlockIndexEntry {
+        uint64_t offset;
+        uint64_t compressed_size;
+        long long first_timestamp;
+    };
+
+    // One decompressed block: timestamps and levels * NUM_FIELDS columns of rows values each
+    struct DecodedBlock {
+        size_t first_row = 0;
+        size_t rows = 0;
+        std::vector<long long> timestamps;
+        std::vector<double> values;
+
+        [[nodiscard]] double value(size_t row, size_t level, TickField field) const {
+            return values[(level * NUM_FIELDS + field) * rows + row];
+        }
+    };
+
+    class BlockFile {
+    public:
+        static constexpr char MAGIC[8] = {'L', 'P', 'B', 'L', 'O', 'C', 'K', '1'};
+        static constexpr uint32_t VERSION = 1;
+        static constexpr uint32_t DEFAULT_BLOCK_ROWS = 1024;
+
+        // Maps the file read-only into memory, blocks are decompressed on demand
+        explicit BlockFile(const std::string& filename);
+        ~BlockFile();
+
+        BlockFile(const BlockFile&) = delete;
+        BlockFile& operator=(const BlockFile&) = delete;
+
+        [[nodiscard]] size_t rows() const { return header->rows; }
+        [[nodiscard]] size_t levels() const { return header->levels; }
+        [[nodiscard]] size_t blockRows() const { return header->block_rows; }
+        [[nodiscard]] size_t numBlocks() const { return header->num_blocks; }
+        [[nodiscard]] const BlockIndexEntry& blockIndex(size_t block) const { return index[block]; }
+
+        // Decompresses a block, reusing the buffers of decoded
+        void decompress(size_t block, DecodedBlock& decoded) const;
+
+        static void write(const std::string& filename, size_t levels,
+                          const std::vector<long long>& timestamps,
+                          const std::vector<std::vector<double>>& columns,
+                          size_t block_rows = DEFAULT_BLOCK_ROWS);
+
+    private:
+        void* mapping = nullptr;
+        size_t mapping_size = 0;
+        const BlockFileHeader* header = nullptr;
+        const BlockIndexEntry* index = nullptr;
+    };
+}
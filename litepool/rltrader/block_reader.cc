@@ -0,0 +1,113 @@
+#include "block_reader.h"
+#include <algorithm>
+#include <stdexcept>
+
+using namespace RLTrader;
+
+BlockReader::BlockReader(const std::string& filename, int start_read_rows, int max_read_rows, int depth)
+    :file(filename),
+     book_levels(std::min(file.levels(), OrderBook::MAX_LEVELS)),
+     start_read(start_read_rows), max_read(max_read_rows), prefetch_depth(depth) {
+    if (file.levels() == 0) {
+        throw std::runtime_error("Block file has no book levels");
+    }
+}
+
+void BlockReader::reset() {
+    this->seek(randomStart(start_read));
+}
+
+void BlockReader::seek(size_t start_row) {
+    prefetcher.reset();
+
+    if (start_row >= file.rows()) {
+        throw std::runtime_error("Failed to skip to start line");
+    }
+
+    // the block index turns a random start into a single block decompression
+    next_row = start_row;
+    end_row = std::min(file.rows(), start_row + static_cast<size_t>(max_read) + 1);
+    last_block = (end_row - 1) / file.blockRows();
+    loadBlock(start_row / file.blockRows());
+    startPrefetch();
+
+    this->advance();
+}
+
+size_t BlockReader::rowAt(long long timestamp) {
+    // the first block starting at or after timestamp, the row is in the block before it or is its first row
+    size_t lo = 0;
+    size_t hi = file.numBlocks();
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        if (file.blockIndex(mid).first_timestamp < timestamp) lo = mid + 1;
+        else hi = mid;
+    }
+
+    if (lo > 0) {
+        DecodedBlock before;
+        file.decompress(lo - 1, before);
+        auto found = std::lower_bound(before.timestamps.begin(), before.timestamps.end(), timestamp);
+        if (found != before.timestamps.end()) {
+            return before.first_row + static_cast<size_t>(found - before.timestamps.begin());
+        }
+    }
+    return std::min(lo * file.blockRows(), file.rows() - 1);
+}
+
+void BlockReader::advance() {
+    if (!hasNext()) {
+        throw std::out_of_range("No more elements");
+    }
+
+    current_row = next_row++;
+    if (current_row >= block.first_row + block.rows) {
+        if (prefetcher) {
+            if (!prefetcher->pop(block)) {
+                throw std::runtime_error("Block prefetcher ended early");
+            }
+        } else {
+            loadBlock(next_block);
+        }
+    }
+}
+
+size_t BlockReader::skip(size_t rows) {
+    size_t moved = std::min(rows, end_row - next_row);
+    if (moved == 0) return 0;
+
+    next_row += moved;
+    current_row = next_row - 1;
+    if (current_row >= block.first_row + block.rows) {
+        // the blocks in between are never read, prefetching restarts after the one the row is in
+        prefetcher.reset();
+        loadBlock(current_row / file.blockRows());
+        startPrefetch();
+    }
+    return moved;
+}
+
+void BlockReader::startPrefetch() {
+    if (prefetch_depth > 0 && next_block <= last_block) {
+        prefetcher = std::make_unique<Prefetcher<DecodedBlock>>([this](DecodedBlock& batch) {
+            file.decompress(next_block++, batch);
+            return next_block <= last_block;
+        }, static_cast<size_t>(prefetch_depth));
+    }
+}
+
+void BlockReader::loadBlock(size_t index) {
+    file.decompress(index, block);
+    next_block = index + 1;
+}
+
+void BlockReader::toBook(OrderBook& book) const {
+    size_t row = current_row - block.first_row;
+    for (size_t level = 0; level < book_levels; ++level) {
+        book.ask_prices[level] = block.value(row, level, ASK_PRICE);
+        book.ask_sizes[level] = block.value(row, level, ASK_AMOUNT);
+        book.bid_prices[level] = block.value(row, level, BID_PRICE);
+        book.bid_sizes[level] = block.value(row, level, BID_AMOUNT);
+    }
+    book.clearFrom(book_levels);
+}
@@ -0,0 +1,58 @@
+#pragma once
+#include <memory>
+#include <string>
+#include "base_reader.h"
+#include "block_file.h"
+#include "prefetcher.h"
+
+namespace RLTrader {
+    class BlockReader final : public BaseReader {
+    public:
+        // prefetch_depth > 0 decompresses that many blocks ahead on a background thread
+        BlockReader(const std::string& filename, int start_read, int max_read, int prefetch_depth = 0);
+
+        void reset() override;
+
+        void seek(size_t start_row) override;
+
+        // Searches the block index, then the one block the row can be in
+        [[nodiscard]] size_t rowAt(long long timestamp) override;
+
+        bool hasNext() override { return next_row < end_row; }
+
+        void advance() override;
+
+        // Decompresses only the block the row lands in
+        size_t skip(size_t rows) override;
+
+        [[nodiscard]] size_t getRow() const override { return current_row; }
+
+        [[nodiscard]] long long getTimeStamp() const override { return block.timestamps[current_row - block.first_row]; }
+
+        [[nodiscard]] double getBestBidPrice() const override { return block.value(current_row - block.first_row, 0, BID_PRICE); }
+
+        [[nodiscard]] double getBestAskPrice() const override { return block.value(current_row - block.first_row, 0, ASK_PRICE); }
+
+        void toBook(OrderBook& book) const override;
+
+    private:
+        void loadBlock(size_t index);
+
+        // Starts prefetching the blocks after the loaded one
+        void startPrefetch();
+
+        BlockFile file;
+        DecodedBlock block;
+        size_t book_levels;
+        int start_read;
+        int max_read;
+        int prefetch_depth;
+        size_t current_row = 0;
+        size_t next_row = 0;
+        size_t end_row = 0;
+        size_t next_block = 0;
+        size_t last_block = 0;
+        // declared last so the I/O thread stops before the file it reads goes away
+        std::unique_ptr<Prefetcher<DecodedBlock>> prefetcher;
+    };
+}
@@ -1,5 +1,6 @@
 #pragma once
 #include <algorithm>
+#include <array>
 #include <stdexcept>
 #include <vector>
 #include <iostream>
@@ -8,10 +9,32 @@
 namespace RLTrader {
 class TemporalTable {
 public:
+    static constexpr u_int MAX_SNAPSHOT_ROWS = 30;
+
+    // Flat copy of the table
+    struct Snapshot {
+        u_int currentRow;
+        u_int rows;
+        std::array<FixedVector<double, 20>, MAX_SNAPSHOT_ROWS> buffer;
+    };
+
     explicit TemporalTable(u_int rows) : currentRow(-1), NUM_ROWS(rows), buffer(rows) {
     }
 
-    void addRow(FixedVector<double, 20>& row) {
+    void snapshot(Snapshot& snap) const {
+        if (NUM_ROWS > MAX_SNAPSHOT_ROWS) throw std::runtime_error("Table too deep to snapshot");
+        snap.currentRow = currentRow;
+        snap.rows = NUM_ROWS;
+        std::copy(buffer.begin(), buffer.end(), snap.buffer.begin());
+    }
+
+    void restore(const Snapshot& snap) {
+        if (snap.rows != NUM_ROWS) throw std::runtime_error("Snapshot of a table of another depth");
+        currentRow = snap.currentRow;
+        std::copy_n(snap.buffer.begin(), NUM_ROWS, buffer.begin());
+    }
+
+    void addRow(const FixedVector<double, 20>& row) {
         if (row.size() != 20) {
 	    std::cout << row.size() << std::endl;
             throw std::runtime_error("Invalid column size");
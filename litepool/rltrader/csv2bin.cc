@@ -0,0 +1,33 @@
+#include <iostream>
+#include <string>
+#include <thread>
+#include "tick_converter.h"
+
+using namespace RLTrader;
+
+// csv2bin <input folder> <output folder> [threads] [bin|blk|dlt]
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        std::cerr << "usage: " << argv[0] << " <input folder> <output folder> [threads] [bin|blk|dlt]" << std::endl;
+        return 1;
+    }
+
+    size_t num_threads = argc > 3 ? std::stoul(argv[3]) : std::thread::hardware_concurrency();
+    std::string extension = argc > 4 ? std::string(".") + argv[4] : ".bin";
+    if (extension != ".bin" && extension != ".blk" && extension != ".dlt") {
+        std::cerr << "unknown output format " << argv[4] << std::endl;
+        return 1;
+    }
+
+    try {
+        auto summaries = TickConverter::convertFolder(argv[1], argv[2], num_threads, extension);
+        for (const auto& summary : summaries) {
+            std::cout << summary.filename << ": " << summary.rows << " rows" << std::endl;
+        }
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
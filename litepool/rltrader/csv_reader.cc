@@ -1,33 +1,41 @@
+#include <algorithm>
+#include <cstdlib>
 #include <sstream>
-#include <random>
 #include <glog/logging.h>
 #include "csv_reader.h"
 
 using namespace RLTrader;
 
-CsvReader::CsvReader(const std::string& fname, int start_read_lines, int max_read_lines):filename(fname), // NOLINT(*-pass-by-value)
-                                                                                         more_data(true), start_read(start_read_lines),
-                                                                                         max_read(max_read_lines), num_reads(0), rows{} {
+CsvReader::CsvReader(const std::string& fname, int start_read_lines, int max_read_lines, int prefetch):filename(fname), // NOLINT(*-pass-by-value)
+                                                                                         rows{}, more_data(true), start_read(start_read_lines),
+                                                                                         max_read(max_read_lines), num_reads(0),
+                                                                                         prefetch_depth(prefetch) {
 }
 
 bool CsvReader::hasNext() {
-    bool retval = this->iterator.hasNext();
-    if (!retval) {
-        if (more_data) {
-            this->readCSV(0);
-            this->iterator.populate(&rows);
-            return this->iterator.hasNext();
+    while (!this->iterator.hasNext()) {
+        if (!more_data) {
+            return false;
         }
-        else {
-            return more_data;
+
+        if (this->prefetcher) {
+            if (!this->prefetcher->pop(rows)) {
+                more_data = false;
+                return false;
+            }
+        } else {
+            this->readCSV(0);
         }
+        this->iterator.populate(&rows);
     }
 
-    return retval;
+    return true;
 }
 
 const DataRow& CsvReader::next() {
-    return this->iterator.next();
+    const auto& row = this->iterator.next();
+    ++current_line;
+    return row;
 }
 
 const DataRow& CsvReader::current() const {
@@ -39,12 +47,22 @@ long long CsvReader::getTimeStamp() const {
 }
 
 double CsvReader::getDouble(const std::string& keyName) const {
-    return this->iterator.getDouble(keyName);
+    int column = TickFile::columnOf(keyName);
+    if (column < 0) {
+        throw std::out_of_range("Unknown column " + keyName);
+    }
+    return this->iterator.getDouble(static_cast<size_t>(column));
 }
 
 void CsvReader::reset() {
+    this->seek(randomStart(start_read));
+}
+
+void CsvReader::seek(size_t start_line) {
+    // stop the I/O thread before touching the stream
+    prefetcher.reset();
     num_reads = 0;
-    headers.clear();
+    schema.clear();
     iterator.reset();
     more_data = true;
     
@@ -52,18 +70,37 @@ void CsvReader::reset() {
     iterator.populate(nullptr);
     rows = std::vector<DataRow>();
     
-    std::random_device rd;  
-    std::mt19937 gen(rd()); 
-    std::uniform_int_distribution<> distr(0, start_read);
-    int start_line = distr(gen);
-    
+    if (!this->line_index) {
+        this->line_index = std::make_unique<LineIndex>(filename);
+    }
+
     if (this->filestream.is_open()) {
         this->filestream.close();
     }
     this->filestream.open(filename, std::ios::in);
-    this->readCSV(start_line);
+    this->readCSV(static_cast<int>(start_line));
     this->iterator.populate(&rows);
     this->iterator.next();
+    this->current_line = start_line;
+
+    if (prefetch_depth > 0 && more_data) {
+        prefetcher = std::make_unique<Prefetcher<std::vector<DataRow>>>(
+            [this](std::vector<DataRow>& batch) { return this->readBatch(batch); },
+            static_cast<size_t>(prefetch_depth));
+    }
+}
+
+size_t CsvReader::rowAt(long long timestamp) {
+    if (!this->line_index) {
+        this->line_index = std::make_unique<LineIndex>(filename);
+    }
+    if (this->line_index->lines() == 0) {
+        throw std::runtime_error("No data lines in " + filename);
+    }
+
+    const long long* timestamps = this->line_index->timestamps();
+    auto row = static_cast<size_t>(std::lower_bound(timestamps, timestamps + line_index->lines(), timestamp) - timestamps);
+    return std::min(row, line_index->lines() - 1);
 }
 
 void CsvReader::readCSV(int start_line) {
@@ -72,10 +109,9 @@ void CsvReader::readCSV(int start_line) {
     }
 
     std::string line;
-    bool batch_read = false;
 
     try {
-        if (headers.empty()) {
+        if (schema.empty()) {
             filestream.clear();
             filestream.seekg(0, std::ios::beg);
             if (!std::getline(filestream, line)) {
@@ -86,71 +122,79 @@ void CsvReader::readCSV(int start_line) {
             std::string header;
             std::getline(headerStream, header, ','); // Skip the first header (ID)
 
+            // resolve the header to DataRow columns once per file
+            int max_column = -1;
             while (std::getline(headerStream, header, ',')) {
-                headers.push_back(header);
+                if (!header.empty() && header.back() == '\r') header.pop_back();
+                int column = TickFile::columnOf(header);
+                schema.push_back(column);
+                max_column = std::max(max_column, column);
             }
+            levels = static_cast<size_t>(max_column + 1) / NUM_FIELDS;
 
-            for(int linenum = 0; linenum < start_line; ++linenum) {
-                if (!std::getline(filestream, line)) {
+            if (start_line > 0) {
+                if (static_cast<size_t>(start_line) >= line_index->lines()) {
                     throw std::runtime_error("Failed to skip to start line");
                 }
+                filestream.seekg(static_cast<std::streamoff>(line_index->offset(start_line)), std::ios::beg);
             }
         }
 
-        rows.clear();
-        int num_lines = 0;
-while (std::getline(filestream, line)) {
-    ++num_reads;
-    std::istringstream lineStream(line);
-    std::string cell;
-
-    if (!std::getline(lineStream, cell, ',')) {
-        continue;  // Skip malformed lines
-    }
-
-    long long id = std::stoll(cell);
-    std::vector<double> values = parseLineToDoubles(line);
-
-    if (values.size() != headers.size()) {
-        LOG(WARNING) << "Skipping malformed line: " << line;
-        continue;  // Skip malformed lines
+        more_data = readBatch(rows);
     }
-
-    std::unordered_map<std::string, double> data;
-    for (size_t i = 0; i < values.size(); ++i) {
-        data[headers[i]] = values[i];
+    catch (const std::exception& e) {
+        throw std::runtime_error("Error reading CSV: " + std::string(e.what()));
     }
+}
 
-    rows.emplace_back(id, data);  // Crash occurs here
+bool CsvReader::readBatch(std::vector<DataRow>& batch) {
+    std::string line;
+    batch.clear();
+    batch.reserve(2500);
+    DataRow row;
+    while (std::getline(filestream, line)) {
+        ++num_reads;
+
+        if (!parseLine(line, row)) {
+            LOG(WARNING) << "Skipping malformed line: " << line;
+            continue;  // Skip malformed lines
+        }
 
-    if (++num_lines >= 2500) {
-        batch_read = true;
-        break;
-    }
+        batch.push_back(row);
 
-    if (num_reads > max_read) {
-        break;
-    }
-}
+        if (batch.size() >= 2500) {
+            return true;
+        }
 
-        if (!batch_read) {
-            more_data = false;
+        if (num_reads > max_read) {
+            break;
         }
     }
-    catch (const std::exception& e) {
-        throw std::runtime_error("Error reading CSV: " + std::string(e.what()));
-    }
+
+    return false;
 }
 
-std::vector<double> CsvReader::parseLineToDoubles(const std::string& line) {
-    std::istringstream stream(line);
-    std::string cell;
-    std::vector<double> results;
-    std::getline(stream, cell, ','); // Skip the first token (ID)
+bool CsvReader::parseLine(const std::string& line, DataRow& row) const {
+    const char* cursor = line.c_str();
+    char* end = nullptr;
+    row.id = std::strtoll(cursor, &end, 10);
+    if (end == cursor || *end != ',') {
+        return false;
+    }
 
-    while (std::getline(stream, cell, ',')) {
-        results.push_back(std::stod(cell));
+    size_t count = 0;
+    cursor = end;
+    while (*cursor == ',') {
+        double value = std::strtod(cursor + 1, &end);
+        if (end == cursor + 1 || count >= schema.size()) {
+            return false;
+        }
+        if (schema[count] >= 0) {
+            row.data[schema[count]] = value;
+        }
+        ++count;
+        cursor = end;
     }
-    return results;
-}
 
+    return count == schema.size();
+}
@@ -4,46 +4,46 @@
 #include <string>
 #include <stdexcept>
 #include <fstream>
-#include <unordered_map>
+#include <array>
+#include <memory>
+#include "base_reader.h"
+#include "line_index.h"
+#include "prefetcher.h"
+#include "tick_file.h"
 
 namespace RLTrader {
     struct DataRow {
-        DataRow(const DataRow& other) : id(other.id), data(other.data) {}
-    
-        DataRow(DataRow&& other) noexcept : id(other.id), data(std::move(other.data)) {}
-    
-        DataRow(long long anId, const std::unordered_map<std::string, double>& dataMap) 
-            : id(anId), data(dataMap) {}
-
-        DataRow& operator=(const DataRow& other) {
-            if (this != &other) {
-                id = other.id;
-                data = other.data;
-            }
-            return *this;
-        }
-    
-        DataRow& operator=(DataRow&& other) noexcept {
-            if (this != &other) {
-                id = other.id;
-                data = std::move(other.data);
-            }
-            return *this;
-        }
+        static constexpr size_t MAX_COLUMNS = OrderBook::MAX_LEVELS * NUM_FIELDS;
 
         long long id = 0;
-        std::unordered_map<std::string, double> data{};
+        std::array<double, MAX_COLUMNS> data{};
+
+        [[nodiscard]] double askPrice(size_t level) const { return data[level * NUM_FIELDS + ASK_PRICE]; }
+        [[nodiscard]] double askAmount(size_t level) const { return data[level * NUM_FIELDS + ASK_AMOUNT]; }
+        [[nodiscard]] double bidPrice(size_t level) const { return data[level * NUM_FIELDS + BID_PRICE]; }
+        [[nodiscard]] double bidAmount(size_t level) const { return data[level * NUM_FIELDS + BID_AMOUNT]; }
 
         double getBestBidPrice() const {
-            return data.find("bids[0].price")->second;
+            return bidPrice(0);
         }
 
         double getBestAskPrice() const {
-            return data.find("asks[0].price")->second;
+            return askPrice(0);
+        }
+
+        // Copies the first levels of the row into an order book and clears the rest
+        void toBook(OrderBook& book, size_t levels) const {
+            for (size_t level = 0; level < levels; ++level) {
+                book.ask_prices[level] = askPrice(level);
+                book.ask_sizes[level] = askAmount(level);
+                book.bid_prices[level] = bidPrice(level);
+                book.bid_sizes[level] = bidAmount(level);
+            }
+            book.clearFrom(levels);
         }
     };
 
-    class CsvReader {
+    class CsvReader final : public BaseReader {
     private:
         class Iterator {
         private:
@@ -76,11 +76,11 @@ namespace RLTrader {
                 return (*rowsPtr)[current - 1].id;
             }
 
-            [[nodiscard]] double getDouble(const std::string& key) const {
+            [[nodiscard]] double getDouble(size_t column) const {
                 if (!rowsPtr || current == 0) {
                     throw std::runtime_error("Invalid iterator state");
                 }
-                return (*rowsPtr)[current - 1].data.at(key);
+                return (*rowsPtr)[current - 1].data[column];
             }
 
             [[nodiscard]] const DataRow& currentRow() const {
@@ -98,36 +98,50 @@ namespace RLTrader {
         std::ifstream filestream;
         std::string filename;
         Iterator iterator;
-        std::vector<std::string> headers;
+        std::vector<int> schema;   // csv value position -> DataRow column, -1 for ignored columns
+        size_t levels = 0;
         std::vector<DataRow> rows;
-        static std::vector<double> parseLineToDoubles(const std::string& line);
+        std::unique_ptr<LineIndex> line_index;   // built on first reset, lets resets seek to any row
+        std::unique_ptr<Prefetcher<std::vector<DataRow>>> prefetcher;   // parses upcoming batches on an I/O thread
+        bool parseLine(const std::string& line, DataRow& row) const;
         void readCSV(int start_line);
+        bool readBatch(std::vector<DataRow>& batch);
         bool more_data;
         int start_read;
         int max_read;
         int num_reads;
+        int prefetch_depth;
+        size_t current_line = 0;
 
     public:
-        CsvReader(const std::string& filename, int start_read, int max_read);
+        // prefetch_depth > 0 parses up to that many batches ahead on a background thread
+        CsvReader(const std::string& filename, int start_read, int max_read, int prefetch_depth = 0);
         ~CsvReader() {
+            prefetcher.reset();
             if (filestream.is_open()) {
                 filestream.close();
             }
         }
         
-        // Delete copy constructor and assignment
+        // Delete copy and move, the prefetch thread refers back to the reader
         CsvReader(const CsvReader&) = delete;
         CsvReader& operator=(const CsvReader&) = delete;
-        
-        // Allow move
-        CsvReader(CsvReader&&) noexcept = default;
-        CsvReader& operator=(CsvReader&&) noexcept = default;
+        CsvReader(CsvReader&&) = delete;
+        CsvReader& operator=(CsvReader&&) = delete;
 
-        bool hasNext();
+        bool hasNext() override;
         const DataRow& next();
+        void advance() override { next(); }
         const DataRow& current() const;
-        long long getTimeStamp() const;
+        size_t getRow() const override { return current_line; }
+        long long getTimeStamp() const override;
+        double getBestBidPrice() const override { return current().getBestBidPrice(); }
+        double getBestAskPrice() const override { return current().getBestAskPrice(); }
+        void toBook(OrderBook& book) const override { current().toBook(book, levels); }
         double getDouble(const std::string& keyname) const;
-        void reset();
+        void reset() override;
+        void seek(size_t start_row) override;
+        // Searches the timestamp column of the line index, the csv file itself is not read
+        size_t rowAt(long long timestamp) override;
     };
 }
@@ -0,0 +1,77 @@
+#include "dataset_cache.h"
+#include <filesystem>
+#include "tick_converter.h"
+
+using namespace RLTrader;
+namespace fs = std::filesystem;
+
+std::mutex DatasetCache::mutex;
+std::unordered_map<std::string, std::shared_ptr<DatasetCache::Entry>> DatasetCache::entries;
+
+std::shared_ptr<const TickFile> DatasetCache::get(const std::string& filename) {
+    std::string key = fs::weakly_canonical(fs::absolute(filename)).string();
+    std::shared_ptr<Entry> entry;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto& slot = entries[key];
+        if (!slot) {
+            slot = std::make_shared<Entry>();
+        }
+        entry = slot;
+    }
+
+    // loads of different files run in parallel, loads of the same file happen once
+    std::lock_guard<std::mutex> lock(entry->mutex);
+    auto data = entry->data.lock();
+    if (!data) {
+        data = load(key);
+        entry->data = data;
+    }
+    return data;
+}
+
+size_t DatasetCache::size() {
+    std::lock_guard<std::mutex> lock(mutex);
+    size_t count = 0;
+    for (const auto& [key, entry] : entries) {
+        std::lock_guard<std::mutex> entry_lock(entry->mutex);
+        if (!entry->data.expired()) ++count;
+    }
+    return count;
+}
+
+std::shared_ptr<const TickFile> DatasetCache::load(const std::string& filename) {
+    if (fs::path(filename).extension() == ".bin") {
+        return std::make_shared<const TickFile>(filename);
+    }
+
+    size_t levels = 0;
+    std::vector<long long> timestamps;
+    std::vector<std::vector<double>> columns;
+    if (fs::path(filename).extension() == ".blk") {
+        // shared data is decompressed once for all envs
+        BlockFile blocks(filename);
+        levels = blocks.levels();
+        timestamps.reserve(blocks.rows());
+        columns.assign(levels * NUM_FIELDS, {});
+        DecodedBlock block;
+        for (size_t index = 0; index < blocks.numBlocks(); ++index) {
+            blocks.decompress(index, block);
+            timestamps.insert(timestamps.end(), block.timestamps.begin(), block.timestamps.end());
+            for (size_t column = 0; column < columns.size(); ++column) {
+                auto first = block.values.begin() + static_cast<long>(column * block.rows);
+                columns[column].insert(columns[column].end(), first, first + static_cast<long>(block.rows));
+            }
+        }
+        return std::make_shared<const TickFile>(levels, std::move(timestamps), columns);
+    }
+
+    if (fs::path(filename).extension() == ".dlt") {
+        DeltaFile deltas(filename);
+        deltas.expand(timestamps, columns);
+        return std::make_shared<const TickFile>(deltas.levels(), std::move(timestamps), columns);
+    }
+
+    TickConverter::readCsv(filename, levels, timestamps, columns);
+    return std::make_shared<const TickFile>(levels, std::move(timestamps), columns);
+}
@@ -0,0 +1,30 @@
+#pragma once
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include "tick_file.h"
+
+namespace RLTrader {
+    // Process-wide, read-only tick data shared by every reader of the same file
+    class DatasetCache {
+    public:
+        // Returns the shared data for a file (.bin mapped, anything else parsed as csv), loading it on first use.
+        // The data is released once the last holder lets go of it.
+        static std::shared_ptr<const TickFile> get(const std::string& filename);
+
+        // Number of files currently held in memory
+        static size_t size();
+
+    private:
+        struct Entry {
+            std::mutex mutex;
+            std::weak_ptr<const TickFile> data;
+        };
+
+        static std::shared_ptr<const TickFile> load(const std::string& filename);
+
+        static std::mutex mutex;
+        static std::unordered_map<std::string, std::shared_ptr<Entry>> entries;
+    };
+}
@@ -0,0 +1,111 @@
+#include "dataset_catalog.h"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include "block_file.h"
+#include "delta_file.h"
+#include "line_index.h"
+#include "tick_converter.h"
+#include "tick_file.h"
+
+using namespace RLTrader;
+namespace fs = std::filesystem;
+
+std::mutex DatasetCatalog::mutex;
+std::unordered_map<std::string, std::shared_ptr<const DatasetCatalog>> DatasetCatalog::catalogs;
+
+DatasetCatalog::DatasetCatalog(const std::string& folder) {
+    auto manifest = fs::path(folder) / TickConverter::MANIFEST;
+    if (fs::exists(manifest)) {
+        readManifest(folder, manifest.string());
+    } else {
+        scan(folder);
+    }
+
+    // files too short to replay a single step are left out
+    files.erase(std::remove_if(files.begin(), files.end(),
+                               [](const CatalogEntry& entry) { return entry.rows < 2; }), files.end());
+    if (files.empty()) {
+        throw std::runtime_error("No replay files in " + folder);
+    }
+
+    for (const auto& entry : files) {
+        total_rows += entry.rows;
+    }
+}
+
+std::shared_ptr<const DatasetCatalog> DatasetCatalog::get(const std::string& folder) {
+    std::string key = fs::weakly_canonical(fs::absolute(folder)).string();
+    std::lock_guard<std::mutex> lock(mutex);
+    auto& catalog = catalogs[key];
+    if (!catalog) {
+        catalog = std::make_shared<const DatasetCatalog>(key);
+    }
+    return catalog;
+}
+
+size_t DatasetCatalog::countRows(const std::string& filename) {
+    auto extension = fs::path(filename).extension();
+    if (extension == ".bin") return TickFile(filename).rows();
+    if (extension == ".blk") return BlockFile(filename).rows();
+    if (extension == ".dlt") return DeltaFile(filename).rows();
+    return LineIndex(filename).lines();
+}
+
+void DatasetCatalog::readManifest(const std::string& folder, const std::string& manifest) {
+    std::ifstream in(manifest);
+    std::string line;
+    if (!std::getline(in, line)) {
+        throw std::runtime_error("Empty manifest " + manifest);
+    }
+
+    while (std::getline(in, line)) {
+        if (line.empty()) continue;
+        std::istringstream fields(line);
+        std::string name;
+        std::string rows;
+        if (!std::getline(fields, name, ',') || !std::getline(fields, rows, ',')) {
+            throw std::runtime_error("Invalid manifest line " + line);
+        }
+        files.push_back({(fs::path(folder) / name).string(), std::stoul(rows)});
+    }
+    dedupe();
+}
+
+void DatasetCatalog::scan(const std::string& folder) {
+    for (const auto& entry : fs::directory_iterator(folder)) {
+        auto extension = entry.path().extension();
+        if (entry.is_regular_file()
+            && (extension == ".csv" || extension == ".bin" || extension == ".blk" || extension == ".dlt")) {
+            files.push_back({entry.path().string(), 0});
+        }
+    }
+
+    std::sort(files.begin(), files.end(),
+              [](const CatalogEntry& lhs, const CatalogEntry& rhs) { return lhs.filename < rhs.filename; });
+    dedupe();
+    for (auto& entry : files) {
+        entry.rows = countRows(entry.filename);
+    }
+}
+
+void DatasetCatalog::dedupe() {
+    auto rank = [](const std::string& filename) {
+        auto extension = fs::path(filename).extension();
+        return extension == ".bin" ? 0 : extension == ".blk" ? 1 : extension == ".dlt" ? 2 : 3;
+    };
+
+    std::vector<CatalogEntry> kept;
+    std::unordered_map<std::string, size_t> by_name;
+    for (auto& entry : files) {
+        auto [it, inserted] = by_name.try_emplace(fs::path(entry.filename).replace_extension().string(), kept.size());
+        if (inserted) {
+            kept.push_back(std::move(entry));
+        } else if (rank(entry.filename) < rank(kept[it->second].filename)) {
+            kept[it->second] = std::move(entry);
+        }
+    }
+    files.swap(kept);
+}
@@ -0,0 +1,44 @@
+#pragma once
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace RLTrader {
+    struct CatalogEntry {
+        std::string filename;
+        size_t rows = 0;
+    };
+
+    // Replay files of a folder with their row counts
+    class DatasetCatalog {
+    public:
+        // Reads the converter manifest if the folder has one, otherwise scans it for .csv/.bin/.blk/.dlt files.
+        // A file kept in several formats is listed once, in the first of .bin, .blk, .dlt and .csv.
+        explicit DatasetCatalog(const std::string& folder);
+
+        // Returns the catalog of a folder, built once per process
+        static std::shared_ptr<const DatasetCatalog> get(const std::string& folder);
+
+        [[nodiscard]] const std::vector<CatalogEntry>& entries() const { return files; }
+
+        [[nodiscard]] size_t totalRows() const { return total_rows; }
+
+        // Number of data rows of a replay file, chosen by extension
+        static size_t countRows(const std::string& filename);
+
+    private:
+        void readManifest(const std::string& folder, const std::string& manifest);
+        void scan(const std::string& folder);
+
+        // Keeps one entry per file name without its extension, the format quickest to replay
+        void dedupe();
+
+        std::vector<CatalogEntry> files;
+        size_t total_rows = 0;
+
+        static std::mutex mutex;
+        static std::unordered_map<std::string, std::shared_ptr<const DatasetCatalog>> catalogs;
+    };
+}
@@ -0,0 +1,177 @@
+#include "delta_file.h"
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "orderbook.h"
+
+using namespace RLTrader;
+
+DeltaFile::DeltaFile(const std::string& filename) {
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Could not open delta file " + filename);
+    }
+
+    struct stat st{};
+    if (::fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(DeltaFileHeader)) {
+        ::close(fd);
+        throw std::runtime_error("Invalid delta file " + filename);
+    }
+
+    mapping_size = static_cast<size_t>(st.st_size);
+    mapping = ::mmap(nullptr, mapping_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+
+    if (mapping == MAP_FAILED) {
+        mapping = nullptr;
+        throw std::runtime_error("Could not map delta file " + filename);
+    }
+
+    header = static_cast<const DeltaFileHeader*>(mapping);
+    snapshots = reinterpret_cast<const uint64_t*>(static_cast<const char*>(mapping) + sizeof(DeltaFileHeader));
+    size_t records_start = sizeof(DeltaFileHeader) + header->num_snapshots * sizeof(uint64_t);
+    bool valid = std::memcmp(header->magic, MAGIC, sizeof(MAGIC)) == 0
+                 && header->version == VERSION
+                 && header->levels <= OrderBook::MAX_LEVELS
+                 && header->snapshot_interval > 0
+                 && records_start <= mapping_size
+                 && header->num_snapshots == (header->rows + header->snapshot_interval - 1) / header->snapshot_interval;
+
+    for (size_t snapshot = 0; valid && snapshot < header->num_snapshots; ++snapshot) {
+        valid = snapshots[snapshot] >= records_start && snapshots[snapshot] < mapping_size;
+    }
+
+    if (!valid) {
+        ::munmap(mapping, mapping_size);
+        mapping = nullptr;
+        throw std::runtime_error("Corrupt delta file " + filename);
+    }
+    ::madvise(mapping, mapping_size, MADV_SEQUENTIAL);
+}
+
+DeltaFile::~DeltaFile() {
+    if (mapping != nullptr) {
+        ::munmap(mapping, mapping_size);
+    }
+}
+
+uint64_t DeltaFile::record(uint64_t offset, long long& timestamp, size_t& count, const unsigned char*& changes) const {
+    const auto* base = static_cast<const unsigned char*>(mapping);
+    if (offset + sizeof(long long) + sizeof(uint8_t) > mapping_size) {
+        throw std::runtime_error("Delta record out of range");
+    }
+
+    std::memcpy(&timestamp, base + offset, sizeof(long long));
+    count = base[offset + sizeof(long long)];
+    changes = base + offset + sizeof(long long) + sizeof(uint8_t);
+    uint64_t next = offset + sizeof(long long) + sizeof(uint8_t) + count * CHANGE_SIZE;
+    if (next > mapping_size) {
+        throw std::runtime_error("Delta record out of range");
+    }
+    return next;
+}
+
+void DeltaFile::change(const unsigned char* changes, size_t ii, size_t& column, double& value) {
+    const unsigned char* entry = changes + ii * CHANGE_SIZE;
+    column = entry[0];
+    std::memcpy(&value, entry + 1, sizeof(double));
+}
+
+void DeltaFile::expand(std::vector<long long>& timestamps, std::vector<std::vector<double>>& columns) const {
+    timestamps.resize(rows());
+    columns.assign(levels() * NUM_FIELDS, std::vector<double>(rows()));
+    std::vector<double> state(columns.size());
+    uint64_t offset = snapshotOffset(0);
+    for (size_t row = 0; row < rows(); ++row) {
+        size_t count = 0;
+        const unsigned char* changes = nullptr;
+        offset = record(offset, timestamps[row], count, changes);
+        for (size_t ii = 0; ii < count; ++ii) {
+            size_t column = 0;
+            double value = 0;
+            change(changes, ii, column, value);
+            if (column >= state.size()) {
+                throw std::runtime_error("Delta column out of range");
+            }
+            state[column] = value;
+        }
+        for (size_t column = 0; column < state.size(); ++column) {
+            columns[column][row] = state[column];
+        }
+    }
+}
+
+void DeltaFile::write(const std::string& filename, size_t levels,
+                      const std::vector<long long>& timestamps,
+                      const std::vector<std::vector<double>>& columns,
+                      size_t snapshot_interval) {
+    if (snapshot_interval == 0 || snapshot_interval > UINT32_MAX) {
+        throw std::runtime_error("Invalid snapshot interval " + std::to_string(snapshot_interval));
+    }
+
+    if (columns.size() != levels * NUM_FIELDS || levels > OrderBook::MAX_LEVELS) {
+        throw std::runtime_error("Column count does not match levels");
+    }
+
+    for (const auto& column : columns) {
+        if (column.size() != timestamps.size()) {
+            throw std::runtime_error("Column length does not match timestamps");
+        }
+    }
+
+    size_t num_rows = timestamps.size();
+    size_t num_snapshots = (num_rows + snapshot_interval - 1) / snapshot_interval;
+    std::vector<uint64_t> snapshot_offsets;
+    snapshot_offsets.reserve(num_snapshots);
+    std::vector<unsigned char> records;
+    uint64_t records_start = sizeof(DeltaFileHeader) + num_snapshots * sizeof(uint64_t);
+
+    for (size_t row = 0; row < num_rows; ++row) {
+        bool snapshot = row % snapshot_interval == 0;
+        if (snapshot) {
+            snapshot_offsets.push_back(records_start + records.size());
+        }
+
+        size_t start = records.size();
+        records.resize(start + sizeof(long long) + sizeof(uint8_t));
+        std::memcpy(records.data() + start, &timestamps[row], sizeof(long long));
+        uint8_t count = 0;
+        for (size_t column = 0; column < columns.size(); ++column) {
+            double value = columns[column][row];
+            if (snapshot || value != columns[column][row - 1]) {
+                size_t entry = records.size();
+                records.resize(entry + CHANGE_SIZE);
+                records[entry] = static_cast<uint8_t>(column);
+                std::memcpy(records.data() + entry + 1, &value, sizeof(double));
+                ++count;
+            }
+        }
+        records[start + sizeof(long long)] = count;
+    }
+
+    std::ofstream out(filename, std::ios::binary | std::ios::trunc);
+    if (!out.is_open()) {
+        throw std::runtime_error("Could not create delta file " + filename);
+    }
+
+    DeltaFileHeader header{};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.levels = static_cast<uint32_t>(levels);
+    header.rows = num_rows;
+    header.snapshot_interval = static_cast<uint32_t>(snapshot_interval);
+    header.num_snapshots = static_cast<uint32_t>(num_snapshots);
+
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(snapshot_offsets.data()),
+              static_cast<std::streamsize>(snapshot_offsets.size() * sizeof(uint64_t)));
+    out.write(reinterpret_cast<const char*>(records.data()), static_cast<std::streamsize>(records.size()));
+
+    if (!out.good()) {
+        throw std::runtime_error("Failed writing delta file " + filename);
+    }
+}
@@ -0,0 +1,62 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "tick_file.h"
+
+namespace RLTrader {
+    // On-disk layout: header, snapshot offsets, then one record per row.
+    // A record is an int64 timestamp, a uint8 change count and that many (uint8 column, double value)
+    // pairs in the tick column layout. Every snapshot_interval rows the record carries all columns.
+    struct DeltaFileHeader {
+        char magic[8];
+        uint32_t version;
+        uint32_t levels;
+        uint64_t rows;
+        uint32_t snapshot_interval;
+        uint32_t num_snapshots;
+    };
+
+    class DeltaFile {
+    public:
+        static constexpr char MAGIC[8] = {'L', 'P', 'D', 'E', 'L', 'T', 'A', '1'};
+        static constexpr uint32_t VERSION = 1;
+        static constexpr uint32_t DEFAULT_SNAPSHOT_INTERVAL = 1000;
+        static constexpr size_t CHANGE_SIZE = sizeof(uint8_t) + sizeof(double);
+
+        // Maps the file read-only into memory
+        explicit DeltaFile(const std::string& filename);
+        ~DeltaFile();
+
+        DeltaFile(const DeltaFile&) = delete;
+        DeltaFile& operator=(const DeltaFile&) = delete;
+
+        [[nodiscard]] size_t rows() const { return header->rows; }
+        [[nodiscard]] size_t levels() const { return header->levels; }
+        [[nodiscard]] size_t snapshotInterval() const { return header->snapshot_interval; }
+        [[nodiscard]] size_t numSnapshots() const { return header->num_snapshots; }
+
+        // Offset of the full snapshot record of row snapshot * snapshotInterval()
+        [[nodiscard]] uint64_t snapshotOffset(size_t snapshot) const { return snapshots[snapshot]; }
+
+        // Reads the record at offset and returns the offset of the next one
+        uint64_t record(uint64_t offset, long long& timestamp, size_t& count, const unsigned char*& changes) const;
+
+        // Decodes a change written by write
+        static void change(const unsigned char* changes, size_t ii, size_t& column, double& value);
+
+        // Replays every row back into a timestamp column and levels * NUM_FIELDS value columns
+        void expand(std::vector<long long>& timestamps, std::vector<std::vector<double>>& columns) const;
+
+        static void write(const std::string& filename, size_t levels,
+                          const std::vector<long long>& timestamps,
+                          const std::vector<std::vector<double>>& columns,
+                          size_t snapshot_interval = DEFAULT_SNAPSHOT_INTERVAL);
+
+    private:
+        void* mapping = nullptr;
+        size_t mapping_size = 0;
+        const DeltaFileHeader* header = nullptr;
+        const uint64_t* snapshots = nullptr;
+    };
+}
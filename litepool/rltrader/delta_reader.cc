@@ -0,0 +1,118 @@
+#include "delta_reader.h"
+#include <algorithm>
+#include <stdexcept>
+
+using namespace RLTrader;
+
+DeltaReader::DeltaReader(const std::string& filename, int start_read_rows, int max_read_rows)
+    :file(filename), start_read(start_read_rows), max_read(max_read_rows) {
+    if (file.levels() == 0) {
+        throw std::runtime_error("Delta file has no book levels");
+    }
+}
+
+void DeltaReader::reset() {
+    this->seek(randomStart(start_read));
+}
+
+void DeltaReader::seek(size_t start_row) {
+    if (start_row >= file.rows()) {
+        throw std::runtime_error("Failed to skip to start line");
+    }
+
+    // rebuild the book from the closest snapshot at or before the start row
+    size_t snapshot = start_row / file.snapshotInterval();
+    next_row = snapshot * file.snapshotInterval();
+    next_offset = file.snapshotOffset(snapshot);
+    end_row = std::min(file.rows(), start_row + static_cast<size_t>(max_read) + 1);
+    while (next_row < start_row) {
+        apply();
+    }
+    this->advance();
+}
+
+size_t DeltaReader::rowAt(long long timestamp) {
+    long long row_timestamp = 0;
+    size_t count = 0;
+    const unsigned char* record_changes = nullptr;
+
+    size_t lo = 0;
+    size_t hi = file.numSnapshots();
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        file.record(file.snapshotOffset(mid), row_timestamp, count, record_changes);
+        if (row_timestamp < timestamp) lo = mid + 1;
+        else hi = mid;
+    }
+    if (lo == 0) return 0;
+
+    size_t row = (lo - 1) * file.snapshotInterval();
+    uint64_t offset = file.snapshotOffset(lo - 1);
+    for (; row < file.rows(); ++row) {
+        offset = file.record(offset, row_timestamp, count, record_changes);
+        if (row_timestamp >= timestamp) return row;
+    }
+    return file.rows() - 1;
+}
+
+void DeltaReader::advance() {
+    if (!hasNext()) {
+        throw std::out_of_range("No more elements");
+    }
+    apply();
+}
+
+size_t DeltaReader::skip(size_t rows) {
+    size_t moved = std::min(rows, end_row - next_row);
+    if (moved == 0) return 0;
+
+    size_t target = next_row + moved;
+    size_t snapshot = (target - 1) / file.snapshotInterval();
+    if (snapshot * file.snapshotInterval() > next_row) {
+        next_row = snapshot * file.snapshotInterval();
+        next_offset = file.snapshotOffset(snapshot);
+    }
+    while (next_row < target) {
+        apply();
+    }
+    return moved;
+}
+
+void DeltaReader::apply() {
+    next_offset = file.record(next_offset, timestamp, change_count, changes);
+    for (size_t ii = 0; ii < change_count; ++ii) {
+        size_t column = 0;
+        double value = 0;
+        DeltaFile::change(changes, ii, column, value);
+        if (column >= file.levels() * NUM_FIELDS) {
+            throw std::runtime_error("Delta column out of range");
+        }
+        state[column] = value;
+    }
+    ++next_row;
+}
+
+void DeltaReader::toBook(OrderBook& book) const {
+    for (size_t level = 0; level < file.levels(); ++level) {
+        book.ask_prices[level] = state[level * NUM_FIELDS + ASK_PRICE];
+        book.ask_sizes[level] = state[level * NUM_FIELDS + ASK_AMOUNT];
+        book.bid_prices[level] = state[level * NUM_FIELDS + BID_PRICE];
+        book.bid_sizes[level] = state[level * NUM_FIELDS + BID_AMOUNT];
+    }
+    book.clearFrom(file.levels());
+}
+
+void DeltaReader::patchBook(OrderBook& book) const {
+    for (size_t ii = 0; ii < change_count; ++ii) {
+        size_t column = 0;
+        double value = 0;
+        DeltaFile::change(changes, ii, column, value);
+        size_t level = column / NUM_FIELDS;
+        switch (column % NUM_FIELDS) {
+            case ASK_PRICE: book.ask_prices[level] = value; break;
+            case ASK_AMOUNT: book.ask_sizes[level] = value; break;
+            case BID_PRICE: book.bid_prices[level] = value; break;
+            default: book.bid_sizes[level] = value; break;
+        }
+    }
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include <array>
+#include <string>
+#include "base_reader.h"
+#include "delta_file.h"
+
+namespace RLTrader {
+    class DeltaReader final : public BaseReader {
+    public:
+        DeltaReader(const std::string& filename, int start_read, int max_read);
+
+        void reset() override;
+
+        void seek(size_t start_row) override;
+
+        // Searches the snapshot records, then walks the rows after the last one before timestamp
+        [[nodiscard]] size_t rowAt(long long timestamp) override;
+
+        bool hasNext() override { return next_row < end_row; }
+
+        void advance() override;
+
+        // Jumps to the last snapshot before the row and applies the records from there
+        size_t skip(size_t rows) override;
+
+        [[nodiscard]] size_t getRow() const override { return next_row - 1; }
+
+        [[nodiscard]] long long getTimeStamp() const override { return timestamp; }
+
+        [[nodiscard]] double getBestBidPrice() const override { return state[BID_PRICE]; }
+
+        [[nodiscard]] double getBestAskPrice() const override { return state[ASK_PRICE]; }
+
+        void toBook(OrderBook& book) const override;
+
+        // Writes only the columns the current row changed
+        void patchBook(OrderBook& book) const override;
+
+    private:
+        // Reads the next record and applies it to state
+        void apply();
+
+        DeltaFile file;
+        std::array<double, OrderBook::MAX_LEVELS * NUM_FIELDS> state{};
+        long long timestamp = 0;
+        size_t change_count = 0;
+        const unsigned char* changes = nullptr;
+        int start_read;
+        int max_read;
+        size_t next_row = 0;
+        size_t end_row = 0;
+        uint64_t next_offset = 0;
+    };
+}
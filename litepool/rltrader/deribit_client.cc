@@ -35,7 +35,8 @@ DeribitClient::DeribitClient(std::string  api_key,
                            std::string  symbol)
     : api_key_(std::move(api_key))
     , api_secret_(std::move(api_secret))
-    , symbol_(std::move(symbol)) {
+    , symbol_(std::move(symbol))
+    , messages_(symbol_) {
 }
 
 DeribitClient::~DeribitClient() {
@@ -282,80 +283,36 @@ void DeribitClient::place_order(const std::string& side,
                               const std::string& type) {
     if (!trading_connected_) return;
     
-    json order_msg = {
-        {"jsonrpc", "2.0"},
-        {"method", side == "buy" ? "private/buy" : "private/sell"},
-        {"params", {
-            {"instrument_name", symbol_},
-            {"amount", size},
-            {"type", type},
-            {"price", price},
-            {"label", label},
-            {"post_only", true}
-        }},
-        {"id", 3}
-    };
-    
-    send_trading_message(order_msg);
+    send_trading_message(messages_.place_message(side, price, size, label, type));
+}
+
+void DeribitClient::edit_order(const std::string& order_id, double price, double size) {
+    if (!trading_connected_) return;
+
+    send_trading_message(DeribitMessages::edit_message(order_id, price, size));
 }
 
 void DeribitClient::cancel_order(const std::string& order_id) {
     if (!trading_connected_) return;
     
-    json cancel_msg = {
-        {"jsonrpc", "2.0"},
-        {"method", "private/cancel"},
-        {"params", {
-            {"order_id", order_id}
-        }},
-        {"id", 4}
-    };
-    
-    send_trading_message(cancel_msg);
+    send_trading_message(DeribitMessages::cancel_message(order_id));
 }
 
 void DeribitClient::cancel_all_by_label(const std::string& label) {
     if (!trading_connected_) return;
 
-    json cancel_by_label_msg = {
-        {"jsonrpc", "2.0"},
-        {"method", "private/cancel_by_label"},
-        {"params", {
-                {"label", label}
-        }},
-        {"id", 7}
-    };
-
-    send_trading_message(cancel_by_label_msg);
+    send_trading_message(DeribitMessages::cancel_by_label_message(label));
 }
 void DeribitClient::cancel_all_orders() {
     if (!trading_connected_) return;
     
-    json cancel_all_msg = {
-        {"jsonrpc", "2.0"},
-        {"method", "private/cancel_all"},
-        {"params", {
-            {"instrument_name", symbol_}
-        }},
-        {"id", 5}
-    };
-    
-    send_trading_message(cancel_all_msg);
+    send_trading_message(messages_.cancel_all_message());
 }
 
 void DeribitClient::get_position() {
     if (!trading_connected_) return;
     
-    json pos_msg = {
-        {"jsonrpc", "2.0"},
-        {"method", "private/get_position"},
-        {"params", {
-            {"instrument_name", symbol_}
-        }},
-        {"id", 6}
-    };
-    
-    send_trading_message(pos_msg);
+    send_trading_message(messages_.position_message());
 }
 
 void DeribitClient::set_OrderBook_cb(std::function<void(const json&)> OrderBook_cb) {
@@ -489,6 +446,21 @@ void DeribitClient::send_trading_message(const json& msg){
     }
 }
 
+void DeribitClient::send_batch(const std::vector<json>& batch) {
+    if (!trading_connected_ || batch.empty()) return;
+
+    {
+        std::lock_guard<std::mutex> lock(trading_write_mutex_);
+        for (const auto& msg : batch) {
+            trading_message_queue_.push(msg);
+        }
+    }
+
+    if (!is_trading_writing_) {
+        write_next_trading_message();
+    }
+}
+
 void DeribitClient::write_next_market_message() {
     if (market_message_queue_.empty() || is_market_writing_) {
         return;
@@ -6,6 +6,7 @@
 #include <boost/asio/ssl.hpp>
 
 #include <nlohmann/json.hpp>
+#include "deribit_messages.h"
 
 #include <mutex>
 #include <thread>
@@ -23,6 +24,7 @@
 #include <memory>
 #include <string>
 #include <queue>
+#include <vector>
 
 namespace RLTrader {
     namespace beast = boost::beast;
@@ -58,11 +60,15 @@ namespace RLTrader {
                         const std::string& label,
                         const std::string& type = "limit");
 
+        void edit_order(const std::string& order_id, double price, double size);
         void cancel_order(const std::string& order_id);
         void cancel_all_by_label(const std::string& label);
         void cancel_all_orders();
         void get_position();
 
+        // Queues a batch of messages under one lock, so they go out back to back on one write chain
+        void send_batch(const std::vector<json>& batch);
+
         // Callback setters
         void set_OrderBook_cb(std::function<void(const json&)> OrderBook_cb);
         void set_private_trade_cb (std::function<void(const json&)> private_trade_cb);
@@ -99,6 +105,7 @@ namespace RLTrader {
         std::string api_key_;
         std::string api_secret_;
         std::string symbol_;
+        DeribitMessages messages_;
 
 
         std::unique_ptr<net::io_context> ioc_;
@@ -1,28 +1,22 @@
 #include "deribit_exchange.h"
 
+#include <chrono>
 #include <iostream>
 
 using namespace RLTrader;
 
 
 DeribitExchange::DeribitExchange(const std::string& symbol, const std::string& api_key, const std::string& api_secret)
-    :db_client(api_key, api_secret, symbol), symbol(symbol), orders_count(0), RESTApi(api_key, api_secret)
+    :db_client(api_key, api_secret, symbol), symbol(symbol), orders_count(0), RESTApi(api_key, api_secret),
+     orders(symbol)
 {
-    this->bid.state = OrderState::CANCELLED;
-    this->ask.state = OrderState::CANCELLED;
-    this->bid.side = OrderSide::BUY;
-    this->ask.side = OrderSide::SELL;
-
-}
-
-void DeribitExchange::toBook(const std::unordered_map<std::string, double>& lob, OrderBook& book)  {
-    throw std::runtime_error("cannot construct OrderBook from unordered_map in prod exchange");
 }
 
 void DeribitExchange::reset() {
     db_client.stop();
     std::lock_guard<std::mutex> lock(this->fill_mutex);
     this->executions.clear();
+    this->orders.clear();
     this->set_callbacks();
     db_client.start();
 }
@@ -43,7 +37,7 @@ void DeribitExchange::handle_private_trade_updates (const json& json_array) {
         order.price = data["price"];
         order.side = data["direction"] == "buy" ? OrderSide::BUY : OrderSide::SELL;
         order.state = OrderState::FILLED;
-        order.orderId = data["order_id"];
+        order.orderId = this->orders.strategyId(data["order_id"], data);
         order.microSecond = data["timestamp"];
         std::lock_guard<std::mutex> lock(this->fill_mutex);
         this->executions.push_back(order);
@@ -76,23 +70,7 @@ void DeribitExchange::handle_order_book_updates (const json& data) {
 void DeribitExchange::handle_order_updates (const json& data) {
     ++this->orders_count;
     if (data["instrument_name"] == symbol) {
-        OrderSide side = data["direction"] == "buy" ? OrderSide::BUY: OrderSide::SELL;
-        double price = data["price"];
-        const std::string& order_id = data["order_id"];
-        OrderState order_state = (data["order_state"] == "open"
-                                 || data["order_state"] == "untriggered") ? OrderState::NEW_ACK : OrderState::CANCELLED;
-
-        std::lock_guard<std::mutex> order_guard(this->order_mutex);
-
-        if (side == OrderSide::BUY) {
-            bid.price = price;
-            bid.state = order_state;
-            bid.orderId = order_id;
-        } else {
-            ask.price = price;
-            ask.state = order_state;
-            ask.orderId = order_id;
-        }
+        this->orders.onOrder(data);
     }
 }
 
@@ -101,9 +79,13 @@ void DeribitExchange::handle_position_updates (const json& data) { // NOLINT(*-c
     //std::cout << data << std::endl;
 }
 
-bool DeribitExchange::next_read(size_t& slot, OrderBook& book) {
-    book = this->book_buffer.get_read_slot(slot);
-    return true;
+const OrderBook* DeribitExchange::next_book(size_t& slot) {
+    return &this->book_buffer.get_read_slot(slot);
+}
+
+long long DeribitExchange::getTimeStamp() const {
+    auto now = std::chrono::system_clock::now().time_since_epoch();
+    return std::chrono::duration_cast<std::chrono::microseconds>(now).count();
 }
 
 void DeribitExchange::fetchPosition(double &posAmount, double &avgPrice) {
@@ -111,42 +93,48 @@ void DeribitExchange::fetchPosition(double &posAmount, double &avgPrice) {
 }
 
 void DeribitExchange::cancelOrders() {
+    this->orders.cancelAll();
     db_client.cancel_all_orders();
 }
 
 
-std::vector<Order> DeribitExchange::getFills() {
+void DeribitExchange::getFills(std::vector<Order>& fills) {
+    fills.clear();
     std::lock_guard<std::mutex> lock(this->fill_mutex);
-    std::vector<Order> fills(std::move(this->executions));
-    this->executions.clear();
-    return fills;
-}
-
-bool is_close(const double& a, const double& b) {
-    return std::abs(a - b) < 0.001;
-}
-
-void DeribitExchange::quote(std::string order_id, OrderSide side, const double& price, const double& amount) {
-    std::string sidestr = side == OrderSide::BUY ? "buy" : "sell";
-    {
-        std::lock_guard<std::mutex> order_guard(this->order_mutex);
-        if (side == OrderSide::BUY) {
-            if (this->bid.state == OrderState::NEW_ACK && is_close(price, this->bid.price)) {
-		return;
-	    }
-        } else {
-            if (this->ask.state == OrderState::NEW_ACK && is_close(price, this->ask.price)) {
-	        return;
-	    }
-        }
-    }
+    fills.swap(this->executions);
+}
 
-    this->db_client.cancel_all_by_label(sidestr);
-    this->db_client.place_order(sidestr, price, amount, sidestr, "limit");
+static Order make_order(OrderState state, OrderId order_id, OrderSide side, double price, double amount, bool is_taker) {
+    Order order{};
+    order.state = state;
+    order.orderId = order_id;
+    order.side = side;
+    order.price = price;
+    order.amount = amount;
+    order.is_taker = is_taker;
+    return order;
 }
 
-void DeribitExchange::market(std::string order_id, OrderSide side, const double& price, const double& amount) {
-    std::string sidestr = side == OrderSide::BUY ? "buy" : "sell";
-    this->db_client.place_order(sidestr, price, amount, sidestr, "market");
+void DeribitExchange::quote(OrderId order_id, OrderSide side, const double& price, const double& amount) {
+    this->submit({make_order(OrderState::NEW, order_id, side, price, amount, false)});
+}
+
+void DeribitExchange::market(OrderId order_id, OrderSide side, const double& price, const double& amount) {
+    this->submit({make_order(OrderState::NEW, order_id, side, price, amount, true)});
+}
+
+void DeribitExchange::amend(OrderId order_id, OrderSide side, const double& price, const double& amount) {
+    this->submit({make_order(OrderState::AMEND, order_id, side, price, amount, false)});
+}
+
+void DeribitExchange::cancel(OrderId order_id, OrderSide side) {
+    this->submit({make_order(OrderState::CANCELLED, order_id, side, 0, 0, false)});
+}
+
+bool DeribitExchange::isLive(OrderId order_id, OrderSide side) const {
+    return this->orders.isLive(order_id, side, this->getTimeStamp());
+}
 
+void DeribitExchange::submit(const std::vector<Order>& batch) {
+    this->db_client.send_batch(this->orders.submit(batch, this->getTimeStamp()));
 }
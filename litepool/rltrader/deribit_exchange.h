@@ -2,6 +2,7 @@
 #include <mutex>
 #include "base_exchange.h"
 #include "deribit_client.h"
+#include "deribit_orders.h"
 #include "deribit_rest.h"
 #include "orderbook_buffer.h"
 
@@ -11,31 +12,31 @@ namespace RLTrader {
         // Constructor
         DeribitExchange(const std::string& symbol, const std::string& api_key, const std::string& api_secret);
 
-        // Generates an OrderBook
-        void toBook(const std::unordered_map<std::string, double>& lob, OrderBook &book) override;
-
         // Resets the exchange's state
         void reset() override;
 
         // Advances to the next row in the data
-        bool next_read(size_t& slot, OrderBook& book) override;
+        const OrderBook* next_book(size_t& slot) override;
 
         void done_read(size_t slot) override { this->book_buffer.commit_read(slot); }
 
+        // Books are read as they arrive, so the live clock is their time
+        [[nodiscard]] long long getTimeStamp() const override;
+
         // fetch dummy zero positions
         void fetchPosition(double& posAmount, double& avgPrice) override;
 
-        // Returns executed orders and clears them
-        std::vector<Order> getFills() override;
+        // Swaps the executed orders into fills
+        void getFills(std::vector<Order>& fills) override;
 
         // Processes order cancellation
         void cancelOrders() override;
 
-        [[nodiscard]] const std::map<std::string, Order>& getBidOrders() const override {
+        [[nodiscard]] const OrderSlots& getBidOrders() const override {
             throw std::runtime_error("Unimplemented");
         }
 
-        [[nodiscard]] const std::map<std::string, Order>& getAskOrders() const override {
+        [[nodiscard]] const OrderSlots& getAskOrders() const override {
             throw std::runtime_error("Unimplemented");
         }
 
@@ -43,9 +44,20 @@ namespace RLTrader {
             throw std::runtime_error("Unimplemented");
         }
 
-        void quote(std::string order_id, OrderSide side, const double& price, const double& amount) override;
+        void quote(OrderId order_id, OrderSide side, const double& price, const double& amount) override;
+
+        void market(OrderId order_id, OrderSide side, const double& price, const double& amount) override;
+
+        // Edits the open order with this id, or places it if it is not open
+        void amend(OrderId order_id, OrderSide side, const double& price, const double& amount) override;
+
+        void cancel(OrderId order_id, OrderSide side) override;
+
+        // Labels every order of the batch with its id and queues all of it on the trading connection at once
+        void submit(const std::vector<Order>& batch) override;
 
-        void market(std::string order_id, OrderSide side, const double& price, const double& amount) override;
+        // Whether the order was sent and not reported closed since, acked or still within DeribitOrders::ACK_TIMEOUT
+        [[nodiscard]] bool isLive(OrderId order_id, OrderSide side) const override;
 
     private:
         void set_callbacks();
@@ -65,9 +77,7 @@ namespace RLTrader {
         std::mutex fill_mutex;
         std::atomic<long> orders_count;
 
-        std::mutex order_mutex;
-        Order bid;
-        Order ask;
+        DeribitOrders orders;  // live orders of the strategy and the requests that keep them in line
     };
 
 } // RLTrader
@@ -0,0 +1,84 @@
+#include "deribit_messages.h"
+
+using namespace RLTrader;
+
+DeribitMessages::DeribitMessages(std::string symbol) : symbol_(std::move(symbol)) {
+}
+
+json DeribitMessages::place_message(const std::string& side,
+                                    double price,
+                                    double size,
+                                    const std::string& label,
+                                    const std::string& type) const {
+    return {
+        {"jsonrpc", "2.0"},
+        {"method", side == "buy" ? "private/buy" : "private/sell"},
+        {"params", {
+            {"instrument_name", symbol_},
+            {"amount", size},
+            {"type", type},
+            {"price", price},
+            {"label", label},
+            {"post_only", true}
+        }},
+        {"id", 3}
+    };
+}
+
+json DeribitMessages::edit_message(const std::string& order_id, double price, double size) {
+    return {
+        {"jsonrpc", "2.0"},
+        {"method", "private/edit"},
+        {"params", {
+            {"order_id", order_id},
+            {"amount", size},
+            {"price", price},
+            {"post_only", true}
+        }},
+        {"id", 8}
+    };
+}
+
+json DeribitMessages::cancel_message(const std::string& order_id) {
+    return {
+        {"jsonrpc", "2.0"},
+        {"method", "private/cancel"},
+        {"params", {
+            {"order_id", order_id}
+        }},
+        {"id", 4}
+    };
+}
+
+json DeribitMessages::cancel_by_label_message(const std::string& label) {
+    return {
+        {"jsonrpc", "2.0"},
+        {"method", "private/cancel_by_label"},
+        {"params", {
+                {"label", label}
+        }},
+        {"id", 7}
+    };
+}
+
+json DeribitMessages::cancel_all_message() const {
+    return {
+        {"jsonrpc", "2.0"},
+        {"method", "private/cancel_all"},
+        {"params", {
+            {"instrument_name", symbol_}
+        }},
+        {"id", 5}
+    };
+}
+
+json DeribitMessages::position_message() const {
+    return {
+        {"jsonrpc", "2.0"},
+        {"method", "private/get_position"},
+        {"params", {
+            {"instrument_name", symbol_}
+        }},
+        {"id", 6}
+    };
+}
@@ -0,0 +1,25 @@
+#pragma once
+#include <string>
+#include <nlohmann/json.hpp>
+
+namespace RLTrader {
+    using json = nlohmann::json;
+
+    // JSON-RPC requests of the Deribit trading connection for one instrument, built apart from the socket
+    // client so the order flow can be checked without a connection
+    class DeribitMessages {
+    public:
+        explicit DeribitMessages(std::string symbol);
+
+        [[nodiscard]] json place_message(const std::string& side, double price, double size,
+                                         const std::string& label, const std::string& type = "limit") const;
+        [[nodiscard]] static json edit_message(const std::string& order_id, double price, double size);
+        [[nodiscard]] static json cancel_message(const std::string& order_id);
+        [[nodiscard]] static json cancel_by_label_message(const std::string& label);
+        [[nodiscard]] json cancel_all_message() const;
+        [[nodiscard]] json position_message() const;
+
+    private:
+        std::string symbol_;
+    };
+}
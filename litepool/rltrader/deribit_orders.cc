@@ -0,0 +1,163 @@
+#include "deribit_orders.h"
+#include <cmath>
+#include <stdexcept>
+
+using namespace RLTrader;
+
+namespace {
+    bool is_close(const double& a, const double& b) {
+        return std::abs(a - b) < 0.001;
+    }
+}
+
+DeribitOrders::DeribitOrders(std::string symbol) : messages(std::move(symbol)) {
+}
+
+void DeribitOrders::clear() {
+    {
+        std::lock_guard<std::mutex> id_lock(this->id_mutex);
+        this->strategy_ids.clear();
+        this->retired_ids.clear();
+    }
+    this->cancelAll();
+}
+
+void DeribitOrders::cancelAll() {
+    std::lock_guard<std::mutex> order_guard(this->order_mutex);
+    this->bid_orders.clear();
+    this->ask_orders.clear();
+}
+
+std::vector<json> DeribitOrders::submit(const std::vector<Order>& batch, long long now) {
+    // private/mass_quote holds one bid and one ask per instrument, so a grid goes out as plain
+    // orders queued back to back, each labelled with its id and tracked by it until it closes
+    std::vector<json> requests;
+    requests.reserve(batch.size() * 2);
+
+    std::lock_guard<std::mutex> order_guard(this->order_mutex);
+    // orders rejected before they were acked are never reported, so they are dropped once timed out,
+    // before the batch is compared against them
+    for (auto* orders : {&this->bid_orders, &this->ask_orders}) {
+        for (auto live = orders->begin(); live != orders->end();) {
+            if (live->second.exchange_id.empty() && now - live->second.order.microSecond >= ACK_TIMEOUT) {
+                live = orders->erase(live);
+            } else {
+                ++live;
+            }
+        }
+    }
+
+    for (const Order& order : batch) {
+        auto& orders = order.side == OrderSide::BUY ? this->bid_orders : this->ask_orders;
+        std::string sidestr = order.side == OrderSide::BUY ? "buy" : "sell";
+        std::string label = DeribitOrders::label(order.side, order.orderId);
+        auto live = orders.find(order.orderId);
+        std::string exchange_id = live != orders.end() ? live->second.exchange_id : std::string();
+
+        if (order.state == OrderState::CANCELLED) {
+            // an order not acked yet has no Deribit id, only its label
+            requests.push_back(exchange_id.empty() ? DeribitMessages::cancel_by_label_message(label)
+                                                   : DeribitMessages::cancel_message(exchange_id));
+            if (live != orders.end()) orders.erase(live);
+            continue;
+        }
+
+        if (order.is_taker) {
+            requests.push_back(this->messages.place_message(sidestr, order.price, order.amount, label, "market"));
+            continue;
+        }
+
+        if (live != orders.end() && is_close(order.price, live->second.order.price)
+            && is_close(order.amount, live->second.order.amount)) {
+            continue;
+        }
+
+        if (!exchange_id.empty()) {
+            // one round trip instead of a cancel plus a new order
+            requests.push_back(DeribitMessages::edit_message(exchange_id, order.price, order.amount));
+        } else {
+            // not acked yet: replace whatever is still out under the label
+            if (live != orders.end()) requests.push_back(DeribitMessages::cancel_by_label_message(label));
+            requests.push_back(this->messages.place_message(sidestr, order.price, order.amount, label, "limit"));
+        }
+
+        LiveOrder& tracked = orders[order.orderId];
+        tracked.order = order;
+        tracked.order.state = exchange_id.empty() ? OrderState::NEW : OrderState::AMEND;
+        tracked.order.microSecond = now;
+        tracked.exchange_id = exchange_id;
+    }
+
+    return requests;
+}
+
+void DeribitOrders::onOrder(const json& data) {
+    OrderSide side = data["direction"] == "buy" ? OrderSide::BUY: OrderSide::SELL;
+    double price = data["price"];
+    double amount = data["amount"];
+    const std::string& order_id = data["order_id"];
+    bool open = data["order_state"] == "open" || data["order_state"] == "untriggered";
+    OrderId id = strategyId(order_id, data);
+
+    if (id != NO_ID) {
+        std::lock_guard<std::mutex> order_guard(this->order_mutex);
+        auto& orders = side == OrderSide::BUY ? this->bid_orders : this->ask_orders;
+        auto live = orders.find(id);
+        if (open && live != orders.end()) {
+            live->second.order.price = price;
+            live->second.order.amount = amount;
+            live->second.order.state = OrderState::NEW_ACK;
+            live->second.exchange_id = order_id;
+        } else if (!open && live != orders.end()
+                   && (live->second.exchange_id.empty() || live->second.exchange_id == order_id)) {
+            // a replacement placed under the same id stays live when the order it replaced closes
+            orders.erase(live);
+        }
+    }
+
+    if (!open) retireId(order_id);
+}
+
+bool DeribitOrders::isLive(OrderId order_id, OrderSide side, long long now) const {
+    std::lock_guard<std::mutex> order_guard(this->order_mutex);
+    const auto& orders = side == OrderSide::BUY ? this->bid_orders : this->ask_orders;
+    auto live = orders.find(order_id);
+    if (live == orders.end()) return false;
+
+    // a rejected request gets no order report, so an order never acked stops counting after ACK_TIMEOUT
+    return !live->second.exchange_id.empty() || now - live->second.order.microSecond < ACK_TIMEOUT;
+}
+
+std::string DeribitOrders::label(OrderSide side, OrderId order_id) {
+    return (side == OrderSide::BUY ? "buy-" : "sell-") + std::to_string(order_id);
+}
+
+OrderId DeribitOrders::strategyId(const std::string& exchange_id, const json& data) {
+    std::lock_guard<std::mutex> lock(this->id_mutex);
+    auto known = this->strategy_ids.find(exchange_id);
+    if (known != this->strategy_ids.end()) return known->second;
+
+    OrderId order_id = NO_ID;
+    if (data.contains("label")) {
+        std::string label = data["label"];
+        size_t dash = label.find('-');
+        try {
+            if (dash != std::string::npos) order_id = std::stoll(label.substr(dash + 1));
+        } catch (const std::logic_error&) {
+            order_id = NO_ID;
+        }
+    }
+
+    if (order_id != NO_ID) this->strategy_ids.emplace(exchange_id, order_id);
+    return order_id;
+}
+
+void DeribitOrders::retireId(const std::string& exchange_id) {
+    std::lock_guard<std::mutex> lock(this->id_mutex);
+    // a closed order's trades can still be on their way, so its id goes a few closed orders later
+    this->retired_ids.push_back(exchange_id);
+    if (this->retired_ids.size() > RETIRED_IDS) {
+        this->strategy_ids.erase(this->retired_ids.front());
+        this->retired_ids.pop_front();
+    }
+}
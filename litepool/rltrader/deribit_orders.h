@@ -0,0 +1,66 @@
+#pragma once
+#include <deque>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "deribit_messages.h"
+#include "order.h"
+
+namespace RLTrader {
+    // The strategy's live Deribit orders, tracked by strategy id from when they are sent until Deribit reports
+    // them closed, and the requests that bring them in line with a batch. Holds no connection,
+    // DeribitExchange sends what it builds and feeds back the order reports.
+    class DeribitOrders {
+    public:
+        static constexpr size_t RETIRED_IDS = 64;  // closed orders whose strategy ids are kept around
+        static constexpr OrderId NO_ID = -1;       // id of orders placed outside the strategy
+        static constexpr long long ACK_TIMEOUT = 5000000;  // microseconds an order that was never acked counts as live
+
+        explicit DeribitOrders(std::string symbol);
+
+        // Forgets every order and id
+        void clear();
+
+        // Forgets the live orders once they are all cancelled
+        void cancelAll();
+
+        // Requests for a batch sent at now: cancels, market orders, edits of acked orders whose price or
+        // amount moved by 0.001 or more, and new orders; orders already live at their price and amount are kept
+        [[nodiscard]] std::vector<json> submit(const std::vector<Order>& batch, long long now);
+
+        // Applies an order report of the instrument: an open order takes the price and amount Deribit reports,
+        // a closed one stops being live
+        void onOrder(const json& data);
+
+        // Whether the order was sent and not reported closed since, acked or still within ACK_TIMEOUT of now
+        [[nodiscard]] bool isLive(OrderId order_id, OrderSide side, long long now) const;
+
+        // Strategy id of a Deribit order, read from the label of its first report and kept by Deribit id
+        // for the reports after it, NO_ID when it has no such label
+        OrderId strategyId(const std::string& exchange_id, const json& data);
+
+        // "side-<id>" label an order of the strategy goes out under
+        static std::string label(OrderSide side, OrderId order_id);
+
+    private:
+        // Forgets the strategy id of an order that was filled, cancelled or rejected
+        void retireId(const std::string& exchange_id);
+
+        // An order of the strategy from when it is sent until Deribit reports it closed
+        struct LiveOrder {
+            Order order;
+            std::string exchange_id;  // empty until Deribit acks it
+        };
+
+        DeribitMessages messages;
+
+        mutable std::mutex order_mutex;
+        std::unordered_map<OrderId, LiveOrder> bid_orders;  // live buy orders by strategy id
+        std::unordered_map<OrderId, LiveOrder> ask_orders;  // live sell orders by strategy id
+
+        std::mutex id_mutex;
+        std::unordered_map<std::string, OrderId> strategy_ids;  // strategy id of each Deribit order id
+        std::deque<std::string> retired_ids;  // closed orders whose ids are still kept for late trade reports
+    };
+}
@@ -1,5 +1,6 @@
 #include "env_adaptor.h"
 #include <algorithm>
+#include <cmath>
 #include <iostream>
 
 using namespace RLTrader;
@@ -11,32 +12,127 @@ EnvAdaptor::EnvAdaptor(Strategy& strat, BaseExchange& exch):
             position_builder(std::make_unique<PositionSignalBuilder>()),
             trade_builder(std::unique_ptr<TradeSignalBuilder>()),
             bid_prices(), ask_prices(), bid_sizes(), ask_sizes() {
+    skipped_books.reserve(MarketSignalBuilder::HISTORY_ROWS);
+}
+
+void EnvAdaptor::setEventStepping(long long interval, size_t max_rows) {
+    this->step_interval = interval;
+    this->step_max_rows = interval > 0 ? std::max<size_t>(max_rows, 1) : 2;
+}
+
+void EnvAdaptor::setBucketStepping(long long interval, size_t max_rows) {
+    this->bucket_interval = std::max(interval, 0LL);
+    this->bucket_max_rows = std::max<size_t>(max_rows, 1);
 }
 
 bool EnvAdaptor::next() {
     std::fill_n(state.begin(), 196, 0);
-    for (int ii=0; ii < 2; ++ii) {
-        OrderBook book;
-        size_t read_slot;
-        if(this->exchange.next_read(read_slot, book)) {
-            this->strategy.next();
-            computeState(book);
-	    #include <algorithm>  // Required for std::copy
-
-           
-            std::copy(book.bid_prices.begin(), book.bid_prices.end(), bid_prices.begin());
-            std::copy(book.ask_prices.begin(), book.ask_prices.end(), ask_prices.begin());
-            std::copy(book.bid_sizes.begin(),  book.bid_sizes.end(),  bid_sizes.begin());
-            std::copy(book.ask_sizes.begin(),  book.ask_sizes.end(),  ask_sizes.begin());
-            this->exchange.done_read(read_slot);
-        } else {
+    if (this->bucket_interval > 0) {
+        return readBucket();
+    }
+
+    const long long step_start = this->exchange.getTimeStamp();
+    if (this->step_interval > 0 && isIdle()) {
+        // no fill can end the step early, so it runs to the interval and the rows before are skipped in bulk
+        size_t rows = this->exchange.rowsUntil(step_start + this->step_interval);
+        if (rows > 0) return advance(std::min(rows, this->step_max_rows));
+    }
+
+    for (size_t rows = 1; rows <= this->step_max_rows; ++rows) {
+        size_t fills = 0;
+        if (!readRow(fills)) {
             return false;
         }
+
+        if (this->step_interval > 0
+            && (fills > 0 || this->exchange.getTimeStamp() - step_start >= this->step_interval)) {
+            break;
+        }
     }
     
     return true;
 }
 
+bool EnvAdaptor::advance(size_t rows) {
+    std::fill_n(state.begin(), 196, 0);
+
+    // position and trade signals only remember the row before, so while flat with nothing working
+    // the last two rows rebuild them exactly and the rest only matter to live market signals
+    size_t skip = 0;
+    if (rows > 2 && isIdle()) {
+        skip = rows - 2;
+    }
+
+    // live market signals agree with a builder fed every row once they have seen the last HISTORY_ROWS books,
+    // so only those books of the skipped rows are built
+    size_t history = precomputedSignals() != nullptr ? 0 : MarketSignalBuilder::HISTORY_ROWS;
+    if (this->exchange.advance(skip, history, this->skipped_books) < skip) return false;
+    for (const auto& book : this->skipped_books) {
+        this->market_builder->add_book(book);
+    }
+
+    for (size_t ii = skip; ii < rows; ++ii) {
+        size_t fills = 0;
+        if (!readRow(fills)) return false;
+    }
+
+    return true;
+}
+
+const double* EnvAdaptor::precomputedSignals() const {
+    // the precomputed rows follow every book, bucketed steps feed the builder one conflated book per step
+    return this->bucket_interval > 0 ? nullptr : this->exchange.marketSignals();
+}
+
+bool EnvAdaptor::isIdle() const {
+    return this->exchange.isIdle() && std::abs(this->strategy.getPosition().getNetAmount()) < 0.00000001;
+}
+
+bool EnvAdaptor::readRow(size_t& fills) {
+    size_t read_slot;
+    const OrderBook* next = this->exchange.next_book(read_slot);
+    if (next == nullptr) {
+        return false;
+    }
+    const OrderBook& book = *next;
+
+    fills = this->strategy.next();
+    computeState(book);
+    std::copy(book.bid_prices.begin(), book.bid_prices.end(), bid_prices.begin());
+    std::copy(book.ask_prices.begin(), book.ask_prices.end(), ask_prices.begin());
+    std::copy(book.bid_sizes.begin(),  book.bid_sizes.end(),  bid_sizes.begin());
+    std::copy(book.ask_sizes.begin(),  book.ask_sizes.end(),  ask_sizes.begin());
+    this->exchange.done_read(read_slot);
+    return true;
+}
+
+bool EnvAdaptor::readBucket() {
+    const OrderBook* next = nullptr;
+    size_t read_slot;
+    const long long bucket_end = (this->exchange.getTimeStamp() / this->bucket_interval + 1) * this->bucket_interval;
+    for (size_t rows = 1; ; ++rows) {
+        next = this->exchange.next_book(read_slot);
+        if (next == nullptr) {
+            return false;
+        }
+        this->strategy.next();
+        if (this->exchange.getTimeStamp() >= bucket_end || rows >= this->bucket_max_rows) break;
+
+        // the rows inside the bucket only go through matching, their books conflate into the last one
+        this->exchange.done_read(read_slot);
+    }
+
+    const OrderBook& book = *next;
+
+    computeState(book);
+    std::copy(book.bid_prices.begin(), book.bid_prices.end(), bid_prices.begin());
+    std::copy(book.ask_prices.begin(), book.ask_prices.end(), ask_prices.begin());
+    std::copy(book.bid_sizes.begin(),  book.bid_sizes.end(),  bid_sizes.begin());
+    std::copy(book.ask_sizes.begin(),  book.ask_sizes.end(),  ask_sizes.begin());
+    this->exchange.done_read(read_slot);
+    return true;
+}
+
 void EnvAdaptor::getState(std::array<double, 196>& st) {
     st = state;
 }
@@ -59,12 +155,46 @@ void EnvAdaptor::reset() {
     std::fill_n(state.begin(), 196, 0);
 }
 
+void EnvAdaptor::snapshot(Snapshot& snap) const {
+    // the trade builder only exists after the first reset
+    TradeSignalBuilder fresh_trades;
+    strategy.snapshot(snap.strategy);
+    market_builder->snapshot(snap.market);
+    position_builder->snapshot(snap.position);
+    (trade_builder ? *trade_builder : fresh_trades).snapshot(snap.trade);
+    snap.max_unrealized_pnl = max_unrealized_pnl;
+    snap.max_realized_pnl = max_realized_pnl;
+    snap.drawdown = drawdown;
+    snap.num_trades = num_trades;
+    snap.state = state;
+    snap.bid_prices = bid_prices;
+    snap.ask_prices = ask_prices;
+    snap.bid_sizes = bid_sizes;
+    snap.ask_sizes = ask_sizes;
+}
+
+void EnvAdaptor::restore(const Snapshot& snap) {
+    if (!trade_builder) trade_builder = std::make_unique<TradeSignalBuilder>();
+    strategy.restore(snap.strategy);
+    market_builder->restore(snap.market);
+    position_builder->restore(snap.position);
+    trade_builder->restore(snap.trade);
+    max_unrealized_pnl = snap.max_unrealized_pnl;
+    max_realized_pnl = snap.max_realized_pnl;
+    drawdown = snap.drawdown;
+    num_trades = snap.num_trades;
+    state = snap.state;
+    bid_prices = snap.bid_prices;
+    ask_prices = snap.ask_prices;
+    bid_sizes = snap.bid_sizes;
+    ask_sizes = snap.ask_sizes;
+}
 
 void EnvAdaptor::getInfo(std::unordered_map<std::string, double>& inf) {
     inf = std::move(info);
 }
 
-void EnvAdaptor::computeInfo(OrderBook &book) {
+void EnvAdaptor::computeInfo(const OrderBook& book) {
     auto bid_price = book.bid_prices[0];
     auto ask_price = book.ask_prices[0];
     PositionInfo posInfo =  strategy.getPosition().getPositionInfo(bid_price, ask_price);
@@ -90,19 +220,27 @@ void EnvAdaptor::computeInfo(OrderBook &book) {
 }
 
 
-void EnvAdaptor::computeState(OrderBook& book)
+void EnvAdaptor::computeState(const OrderBook& book)
 {
     auto bid_price = book.bid_prices[0];
     auto ask_price = book.ask_prices[0];
-    auto market_signals = market_builder->add_book(book);
     PositionInfo position_info = strategy.getPosition().getPositionInfo(book.bid_prices[0], book.ask_prices[0]);
     if (position_info.inventoryPnL > max_unrealized_pnl) max_unrealized_pnl = position_info.inventoryPnL;
     if (position_info.tradingPnL > max_realized_pnl) max_realized_pnl = position_info.tradingPnL;
     auto position_signals = position_builder->add_info(position_info, bid_price, ask_price);
     TradeInfo trade_info = strategy.getPosition().getTradeInfo();
     auto trade_signals = trade_builder->add_trade(trade_info, bid_price, ask_price);
-    std::copy_n(state.begin(), market_signals.size(), market_signals.begin());
-    std::copy_n(state.begin() + market_signals.size(), position_signals.size(), position_signals.begin());
-    std::copy_n(state.begin() + market_signals.size() + position_signals.size(), trade_signals.size(), market_signals.begin());
+
+    // market signals only depend on the replayed books, use the exchange's precomputed row when it has one
+    const double* precomputed = precomputedSignals();
+    if (precomputed != nullptr) {
+        std::copy_n(precomputed, MarketSignalBuilder::NUM_SIGNALS, state.begin());
+    } else {
+        auto market_signals = market_builder->add_book(book);
+        std::copy_n(market_signals.begin(), MarketSignalBuilder::NUM_SIGNALS, state.begin());
+    }
+    auto position_offset = state.begin() + MarketSignalBuilder::NUM_SIGNALS;
+    std::copy_n(position_signals.begin(), position_signals.size(), position_offset);
+    std::copy_n(trade_signals.begin(), trade_signals.size(), position_offset + static_cast<long>(position_signals.size()));
     computeInfo(book);
 }
@@ -1,4 +1,5 @@
 #pragma once
+#include <unordered_map>
 #include "strategy.h"
 #include "base_exchange.h"
 #include "market_signal_builder.h"
@@ -8,22 +9,63 @@
 namespace RLTrader {
 class EnvAdaptor { 
 public:
+    // Flat copy of the strategy, the signal builders and the last state, the exchange is snapshotted on its own
+    struct Snapshot {
+        Strategy::Snapshot strategy;
+        MarketSignalBuilder::Snapshot market;
+        PositionSignalBuilder::Snapshot position;
+        TradeSignalBuilder::Snapshot trade;
+        double max_unrealized_pnl;
+        double max_realized_pnl;
+        double drawdown;
+        long num_trades;
+        std::array<double, 196> state;
+        FixedVector<double, 20> bid_prices;
+        FixedVector<double, 20> ask_prices;
+        FixedVector<double, 20> bid_sizes;
+        FixedVector<double, 20> ask_sizes;
+    };
+
     EnvAdaptor(Strategy& strat, BaseExchange& exch);
     ~EnvAdaptor()  = default;
     void quote(int buy_spread, int sell_spread, int buy_percent, int sell_percent) ;
     void reset() ;
     bool next() ;
+
+    // Replays rows rows, skipping order matching and all but the last two rows' signals while idle and flat
+    bool advance(size_t rows);
+
+    // Steps run until a fill, interval microseconds of data time or max_rows rows, interval 0 steps two rows
+    void setEventStepping(long long interval, size_t max_rows);
+
+    // Steps end on the first row at or past the next multiple of interval microseconds of data time or after
+    // max_rows rows. The rows before it only go through matching, the market signals are fed the step's last
+    // book once, so they aggregate over buckets rather than rows and precomputed row features are not used.
+    // Takes over from event stepping, interval 0 turns it off.
+    void setBucketStepping(long long interval, size_t max_rows);
     void getInfo(std::unordered_map<std::string, double>& info) ;
     void getState(std::array<double, 196>& state) ;
+    void snapshot(Snapshot& snap) const;
+    void restore(const Snapshot& snap);
 private:;
-    void computeState(OrderBook& book);
-    void computeInfo(OrderBook& book);
+    bool readRow(size_t& fills);
+    bool readBucket();
+    // Nothing working and no position, so rows read cannot fill or change the position
+    bool isIdle() const;
+    // The exchange's precomputed market signals for the row read, nullptr when they must be built live
+    const double* precomputedSignals() const;
+    void computeState(const OrderBook& book);
+    void computeInfo(const OrderBook& book);
     Strategy& strategy;
     BaseExchange& exchange;
     double max_unrealized_pnl = 0;
     double max_realized_pnl = 0;
     double drawdown = 0;
     long num_trades = 0;
+    long long step_interval = 0;
+    size_t step_max_rows = 2;
+    long long bucket_interval = 0;
+    size_t bucket_max_rows = 1;
     std::unique_ptr<MarketSignalBuilder> market_builder;
     std::unique_ptr<PositionSignalBuilder> position_builder;
     std::unique_ptr<TradeSignalBuilder> trade_builder;
@@ -33,5 +75,6 @@ private:;
     FixedVector<double, 20> ask_prices;
     FixedVector<double, 20> bid_sizes;
     FixedVector<double, 20> ask_sizes;
+    std::vector<OrderBook> skipped_books;  // books of the last rows a fast-forward skipped, for the market signals
 };
 }
@@ -0,0 +1,25 @@
+#include "episode_sampler.h"
+#include <algorithm>
+
+using namespace RLTrader;
+
+EpisodeSampler::EpisodeSampler(std::shared_ptr<const DatasetCatalog> data, int max_read_rows, int start_read_rows)
+    :catalog(std::move(data)), max_read(static_cast<size_t>(std::max(max_read_rows, 1))),
+     start_read(static_cast<size_t>(std::max(start_read_rows, 0))) {
+    std::vector<double> weights;
+    weights.reserve(catalog->entries().size());
+    for (const auto& entry : catalog->entries()) {
+        weights.push_back(static_cast<double>(entry.rows));
+    }
+    file_distr = std::discrete_distribution<size_t>(weights.begin(), weights.end());
+}
+
+Episode EpisodeSampler::sample(std::mt19937& gen) {
+    const auto& entry = catalog->entries()[file_distr(gen)];
+
+    // a reader replays start_row plus max_read rows, shorter files start at the top
+    size_t last_start = entry.rows > max_read + 1 ? entry.rows - max_read - 1 : 0;
+    if (start_read > 0) last_start = std::min(last_start, start_read);
+    std::uniform_int_distribution<size_t> start_distr(0, last_start);
+    return {entry.filename, start_distr(gen)};
+}
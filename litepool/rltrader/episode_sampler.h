@@ -0,0 +1,27 @@
+#pragma once
+#include <memory>
+#include <random>
+#include <string>
+#include "dataset_catalog.h"
+
+namespace RLTrader {
+    struct Episode {
+        std::string filename;
+        size_t start_row = 0;
+    };
+
+    // Picks a file, weighted by its length, and a start row so the episode window fits in it
+    class EpisodeSampler {
+    public:
+        // start_read > 0 keeps start rows in [0, start_read] as the readers' own random start does
+        EpisodeSampler(std::shared_ptr<const DatasetCatalog> catalog, int max_read, int start_read = 0);
+
+        Episode sample(std::mt19937& gen);
+
+    private:
+        std::shared_ptr<const DatasetCatalog> catalog;
+        std::discrete_distribution<size_t> file_distr;
+        size_t max_read;
+        size_t start_read;
+    };
+}
@@ -0,0 +1,147 @@
+#include "feature_store.h"
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "dataset_cache.h"
+#include "market_signal_builder.h"
+
+using namespace RLTrader;
+
+std::mutex FeatureStore::mutex;
+std::unordered_map<std::string, std::shared_ptr<FeatureStore::Entry>> FeatureStore::entries;
+
+FeatureStore::FeatureStore(const std::string& filename) {
+    struct stat st{};
+    if (::stat(filename.c_str(), &st) != 0) {
+        throw std::runtime_error("Could not open file " + filename);
+    }
+
+    auto file_size = static_cast<uint64_t>(st.st_size);
+    int64_t file_mtime = static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+    std::string feature_file = featureFile(filename);
+
+    if (open(feature_file, file_size, file_mtime)) {
+        return;
+    }
+
+    build(filename, owned_values);
+    num_width = MarketSignalBuilder::NUM_SIGNALS;
+    num_rows = owned_values.size() / num_width;
+
+    // publish atomically so that concurrent readers never see a partial file
+    std::random_device rd;
+    std::string temp_file = feature_file + "." + std::to_string(::getpid()) + "." + std::to_string(rd());
+    std::ofstream out(temp_file, std::ios::binary | std::ios::trunc);
+    if (out.is_open()) {
+        FeatureFileHeader header{};
+        std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+        header.file_size = file_size;
+        header.file_mtime = file_mtime;
+        header.rows = num_rows;
+        header.width = num_width;
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(owned_values.data()),
+                  static_cast<std::streamsize>(owned_values.size() * sizeof(double)));
+        out.close();
+
+        if (out.good() && std::rename(temp_file.c_str(), feature_file.c_str()) == 0
+            && open(feature_file, file_size, file_mtime)) {
+            std::vector<double>().swap(owned_values);
+            return;
+        }
+        std::remove(temp_file.c_str());
+    }
+
+    // read-only folder, keep the features in memory
+    values = owned_values.data();
+}
+
+FeatureStore::~FeatureStore() {
+    if (mapping != nullptr) {
+        ::munmap(mapping, mapping_size);
+    }
+}
+
+std::shared_ptr<const FeatureStore> FeatureStore::get(const std::string& filename) {
+    std::string key = std::filesystem::weakly_canonical(std::filesystem::absolute(filename)).string();
+    std::shared_ptr<Entry> entry;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto& slot = entries[key];
+        if (!slot) {
+            slot = std::make_shared<Entry>();
+        }
+        entry = slot;
+    }
+
+    // builds of different files run in parallel, the build of a file happens once
+    std::lock_guard<std::mutex> lock(entry->mutex);
+    auto store = entry->store.lock();
+    if (!store) {
+        store = std::make_shared<const FeatureStore>(key);
+        entry->store = store;
+    }
+    return store;
+}
+
+bool FeatureStore::open(const std::string& feature_file, uint64_t file_size, int64_t file_mtime) {
+    int fd = ::open(feature_file.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat st{};
+    if (::fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(FeatureFileHeader)) {
+        ::close(fd);
+        return false;
+    }
+
+    void* map = ::mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (map == MAP_FAILED) {
+        return false;
+    }
+
+    const auto* header = static_cast<const FeatureFileHeader*>(map);
+    if (std::memcmp(header->magic, MAGIC, sizeof(MAGIC)) != 0
+        || header->file_size != file_size
+        || header->file_mtime != file_mtime
+        || header->width != MarketSignalBuilder::NUM_SIGNALS
+        || sizeof(FeatureFileHeader) + header->rows * header->width * sizeof(double) != static_cast<size_t>(st.st_size)) {
+        ::munmap(map, static_cast<size_t>(st.st_size));
+        return false;
+    }
+
+    mapping = map;
+    mapping_size = static_cast<size_t>(st.st_size);
+    num_rows = header->rows;
+    num_width = header->width;
+    values = reinterpret_cast<const double*>(static_cast<const char*>(map) + sizeof(FeatureFileHeader));
+    return true;
+}
+
+void FeatureStore::build(const std::string& filename, std::vector<double>& signals) {
+    auto data = DatasetCache::get(filename);
+    MarketSignalBuilder builder;
+    signals.clear();
+    signals.reserve(data->rows() * MarketSignalBuilder::NUM_SIGNALS);
+
+    for (size_t row = 0; row < data->rows(); ++row) {
+        OrderBook book;
+        for (size_t level = 0; level < data->levels(); ++level) {
+            book.ask_prices[level] = data->column(level, ASK_PRICE)[row];
+            book.ask_sizes[level] = data->column(level, ASK_AMOUNT)[row];
+            book.bid_prices[level] = data->column(level, BID_PRICE)[row];
+            book.bid_sizes[level] = data->column(level, BID_AMOUNT)[row];
+        }
+        auto row_signals = builder.add_book(book);
+        signals.insert(signals.end(), row_signals.begin(), row_signals.end());
+    }
+}
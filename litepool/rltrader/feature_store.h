@@ -0,0 +1,69 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace RLTrader {
+    // Market signals of every row of a replay file, row major
+    struct FeatureFileHeader {
+        char magic[8];
+        uint64_t file_size;
+        int64_t file_mtime;
+        uint64_t rows;
+        uint64_t width;
+    };
+
+    class FeatureStore {
+    public:
+        static constexpr char MAGIC[8] = {'L', 'P', 'F', 'E', 'A', 'T', '0', '1'};
+
+        // Opens the feature sidecar next to the file, computing it first if it is missing or stale
+        explicit FeatureStore(const std::string& filename);
+        ~FeatureStore();
+
+        FeatureStore(const FeatureStore&) = delete;
+        FeatureStore& operator=(const FeatureStore&) = delete;
+
+        // Returns the features of a file, opened once per process and shared by every env
+        static std::shared_ptr<const FeatureStore> get(const std::string& filename);
+
+        [[nodiscard]] size_t rows() const { return num_rows; }
+
+        [[nodiscard]] size_t width() const { return num_width; }
+
+        // MarketSignalBuilder output after replaying the file from its first row up to row.
+        // A builder started on a later row agrees once it has seen HISTORY_ROWS books.
+        // Throws if the row is past the file, as when the file changed after the store was opened.
+        [[nodiscard]] const double* row(size_t row) const {
+            if (row >= num_rows) {
+                throw std::out_of_range("Feature row " + std::to_string(row) + " past " + std::to_string(num_rows) + " rows");
+            }
+            return values + row * num_width;
+        }
+
+        static std::string featureFile(const std::string& filename) { return filename + ".features"; }
+
+    private:
+        struct Entry {
+            std::mutex mutex;
+            std::weak_ptr<const FeatureStore> store;
+        };
+
+        bool open(const std::string& feature_file, uint64_t file_size, int64_t file_mtime);
+        static void build(const std::string& filename, std::vector<double>& signals);
+
+        void* mapping = nullptr;
+        size_t mapping_size = 0;
+        size_t num_rows = 0;
+        size_t num_width = 0;
+        const double* values = nullptr;
+        std::vector<double> owned_values;
+
+        static std::mutex mutex;
+        static std::unordered_map<std::string, std::shared_ptr<Entry>> entries;
+    };
+}
@@ -0,0 +1,196 @@
+#include "journal.h"
+#include <cerrno>
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <fcntl.h>
+#include <unistd.h>
+#include "orderbook.h"
+#include "sim_exchange.h"
+
+using namespace RLTrader;
+
+JournalWriter::JournalWriter(const std::string& filename, int env_id)
+    :fd(::open(filename.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644)), env_id(env_id) {
+    if (fd < 0) {
+        throw std::runtime_error("Could not open journal " + filename);
+    }
+}
+
+JournalWriter::~JournalWriter() {
+    try {
+        flush();
+    } catch (const std::runtime_error&) {
+        // nothing left to report a failed last write to
+    }
+    ::close(fd);
+}
+
+void JournalWriter::record(long long timestamp, uint64_t row, JournalEvent event, int side,
+                           double price, double amount, OrderId order_id) {
+    if (count == BUFFER_RECORDS) flush();
+
+    auto& rec = buffer[count++];
+    rec.timestamp = timestamp;
+    rec.row = row;
+    rec.env_id = env_id;
+    rec.event = event;
+    rec.side = static_cast<uint8_t>(side);
+    rec.price = price;
+    rec.amount = amount;
+    rec.order_id = order_id;
+}
+
+void JournalWriter::recordEpisode(long long timestamp, const EpisodeStart& episode) {
+    record(timestamp, episode.start_row, JournalEvent::RESET, 0, 0, 0, episode.seed);
+
+    const std::string& name = episode.filename;
+    for (size_t offset = 0; offset < name.size(); offset += JOURNAL_NAME_PIECE) {
+        size_t length = std::min(JOURNAL_NAME_PIECE, name.size() - offset);
+        record(timestamp, 0, JournalEvent::EPISODE_FILE, static_cast<int>(length), 0, 0, 0);
+        std::memcpy(reinterpret_cast<char*>(&buffer[count - 1]) + JOURNAL_NAME_OFFSET, name.data() + offset, length);
+    }
+}
+
+void JournalWriter::flush() {
+    const auto* data = reinterpret_cast<const char*>(buffer.data());
+    size_t remaining = count * sizeof(JournalRecord);
+    count = 0;
+
+    while (remaining > 0) {
+        ssize_t written = ::write(fd, data, remaining);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            throw std::runtime_error("Failed writing journal");
+        }
+        data += written;
+        remaining -= static_cast<size_t>(written);
+    }
+}
+
+JournalReader::JournalReader(const std::string& filename, int env_id) {
+    std::ifstream in(filename, std::ios::binary | std::ios::ate);
+    if (!in.is_open()) {
+        throw std::runtime_error("Could not open journal " + filename);
+    }
+
+    auto size = static_cast<size_t>(in.tellg());
+    if (size % sizeof(JournalRecord) != 0) {
+        throw std::runtime_error("Truncated journal " + filename);
+    }
+
+    std::vector<JournalRecord> all(size / sizeof(JournalRecord));
+    in.seekg(0);
+    in.read(reinterpret_cast<char*>(all.data()), static_cast<std::streamsize>(size));
+    if (!in.good()) {
+        throw std::runtime_error("Failed reading journal " + filename);
+    }
+
+    for (const auto& rec : all) {
+        if (env_id < 0 || rec.env_id == env_id) journal.push_back(rec);
+    }
+}
+
+size_t JournalReader::episodes() const {
+    size_t resets = 0;
+    for (const auto& rec : journal) {
+        if (rec.event == JournalEvent::RESET) ++resets;
+    }
+    return resets;
+}
+
+std::vector<JournalRecord>::const_iterator JournalReader::find(size_t episode) const {
+    auto rec = journal.begin();
+    for (size_t resets = 0; rec != journal.end(); ++rec) {
+        if (rec->event == JournalEvent::RESET && resets++ == episode) break;
+    }
+
+    if (rec == journal.end()) {
+        throw std::runtime_error("Journal has no episode " + std::to_string(episode));
+    }
+    return rec;
+}
+
+EpisodeStart JournalReader::episode(size_t episode) const {
+    auto rec = find(episode);
+    EpisodeStart start;
+    start.start_row = rec->row;
+    start.seed = static_cast<unsigned>(rec->order_id);
+    for (++rec; rec != journal.end() && rec->event == JournalEvent::EPISODE_FILE; ++rec) {
+        start.filename.append(reinterpret_cast<const char*>(&*rec) + JOURNAL_NAME_OFFSET,
+                              std::min<size_t>(rec->side, JOURNAL_NAME_PIECE));
+    }
+
+    if (start.filename.empty()) {
+        throw std::runtime_error("Journal episode " + std::to_string(episode) + " has no replay file");
+    }
+    return start;
+}
+
+std::vector<Order> JournalReader::replay(SimExchange& exch, size_t episode) const {
+    auto start = this->episode(episode);
+    exch.setEpisode(start.filename, start.start_row);
+    exch.setEpisodeSeed(start.seed);
+    exch.reset();
+
+    auto rec = find(episode);
+    std::vector<Order> fills;
+    std::vector<Order> reported;
+    size_t slot = 0;
+    uint64_t rows = 0;
+
+    std::vector<Order> batch;
+    size_t batched = 0;  // requests of the current batch still to come
+
+    for (++rec; rec != journal.end() && rec->event != JournalEvent::RESET; ++rec) {
+        for (; rows < rec->row; ++rows) {
+            if (exch.next_book(slot) == nullptr) return fills;
+            exch.done_read(slot);
+            exch.getFills(reported);
+            fills.insert(fills.end(), reported.begin(), reported.end());
+        }
+
+        auto side = static_cast<OrderSide>(rec->side);
+        if (batched > 0) {
+            Order order{};
+            order.is_taker = rec->event == JournalEvent::MARKET;
+            order.orderId = rec->order_id;
+            order.side = side;
+            order.price = rec->price;
+            order.amount = rec->amount;
+            order.state = rec->event == JournalEvent::CANCEL ? OrderState::CANCELLED
+                          : rec->event == JournalEvent::AMEND ? OrderState::AMEND : OrderState::NEW;
+            batch.push_back(order);
+            if (--batched == 0) exch.submit(batch);
+            continue;
+        }
+
+        switch (rec->event) {
+            case JournalEvent::BATCH:
+                batch.clear();
+                batched = static_cast<size_t>(rec->amount);
+                break;
+            case JournalEvent::QUOTE:
+                exch.quote(rec->order_id, side, rec->price, rec->amount);
+                break;
+            case JournalEvent::MARKET:
+                exch.market(rec->order_id, side, rec->price, rec->amount);
+                break;
+            case JournalEvent::AMEND:
+                exch.amend(rec->order_id, side, rec->price, rec->amount);
+                break;
+            case JournalEvent::CANCEL:
+                exch.cancel(rec->order_id, side);
+                break;
+            case JournalEvent::CANCEL_ALL:
+                exch.cancelOrders();
+                break;
+            default:
+                // fills are what the replay reproduces, file names were read above
+                break;
+        }
+    }
+
+    return fills;
+}
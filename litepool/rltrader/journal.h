@@ -0,0 +1,103 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include "base_exchange.h"
+#include "order.h"
+
+namespace RLTrader {
+    class SimExchange;
+
+    enum class JournalEvent : uint8_t {
+        RESET = 1,
+        QUOTE = 2,
+        MARKET = 3,
+        AMEND = 4,
+        CANCEL = 5,
+        CANCEL_ALL = 6,
+        FILL = 7,
+        BATCH = 8,         // the amount requests after it went out in one batch
+        EPISODE_FILE = 9   // a piece of the replayed file's name, following a reset
+    };
+
+    // On-disk record, a journal is these back to back with no header.
+    // A reset keeps its start row in row and its latency seed in order_id, the file name follows it in
+    // EPISODE_FILE records holding side bytes of the name in place of price, amount and order_id.
+    // Every other record's row counts the rows read since the reset.
+    struct JournalRecord {
+        int64_t timestamp;  // exchange time of the event in microseconds
+        uint64_t row;       // tells apart rows sharing a timestamp
+        int32_t env_id;
+        JournalEvent event;
+        uint8_t side;       // OrderSide, 0 for events without one
+        uint16_t reserved;
+        double price;
+        double amount;
+        int64_t order_id;
+    };
+
+    // bytes of an EPISODE_FILE record carrying a piece of the file name
+    constexpr size_t JOURNAL_NAME_OFFSET = offsetof(JournalRecord, price);
+    constexpr size_t JOURNAL_NAME_PIECE = sizeof(double) * 2 + sizeof(int64_t);
+
+    static_assert(sizeof(JournalRecord) == 48 && std::is_trivially_copyable_v<JournalRecord>,
+                  "Journal records are written as fixed size blobs");
+
+    // Appends the records of one env to a journal file. Every env owns its writer and is stepped by one
+    // thread at a time, so records are buffered without locks; a full buffer goes out in a single
+    // O_APPEND write, which lets envs of a pool share one file.
+    class JournalWriter {
+    public:
+        static constexpr size_t BUFFER_RECORDS = 1024;
+
+        JournalWriter(const std::string& filename, int env_id);
+        ~JournalWriter();
+
+        JournalWriter(const JournalWriter&) = delete;
+        JournalWriter& operator=(const JournalWriter&) = delete;
+
+        void record(long long timestamp, uint64_t row, JournalEvent event, int side,
+                    double price, double amount, OrderId order_id);
+
+        // Records a reset into an episode of a replayed file
+        void recordEpisode(long long timestamp, const EpisodeStart& episode);
+
+        // Writes out the buffered records
+        void flush();
+
+    private:
+        int fd;
+        int env_id;
+        size_t count = 0;
+        std::array<JournalRecord, BUFFER_RECORDS> buffer{};
+    };
+
+    // Reads the records a journal holds for one env
+    class JournalReader {
+    public:
+        // env_id -1 keeps the records of every env
+        explicit JournalReader(const std::string& filename, int env_id = -1);
+
+        [[nodiscard]] const std::vector<JournalRecord>& records() const { return journal; }
+
+        // Episodes are the runs of records after each reset
+        [[nodiscard]] size_t episodes() const;
+
+        // File, start row and latency seed of an episode
+        [[nodiscard]] EpisodeStart episode(size_t episode) const;
+
+        // Replays an episode's order flow into exch and returns the fills it reports, in reporting order.
+        // exch is reset into the journaled file, start row and latency seed here; it needs the latency
+        // models the episode ran with. Each order goes in after the row it was sent on.
+        std::vector<Order> replay(SimExchange& exch, size_t episode = 0) const;
+
+    private:
+        // First record of an episode, its reset
+        [[nodiscard]] std::vector<JournalRecord>::const_iterator find(size_t episode) const;
+
+        std::vector<JournalRecord> journal;
+    };
+}
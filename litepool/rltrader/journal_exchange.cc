@@ -0,0 +1,77 @@
+#include "journal_exchange.h"
+
+using namespace RLTrader;
+
+JournalExchange::JournalExchange(BaseExchange& exch, const std::string& filename, int env_id)
+    :exchange(exch), writer(filename, env_id) {
+}
+
+void JournalExchange::reset() {
+    exchange.reset();
+    rows = 0;
+    // episodes are written out whole, so a crashed run still leaves the ones before it
+    writer.flush();
+    EpisodeStart episode;
+    if (exchange.getEpisode(episode)) {
+        writer.recordEpisode(exchange.getTimeStamp(), episode);
+    } else {
+        writer.record(exchange.getTimeStamp(), rows, JournalEvent::RESET, 0, 0, 0, 0);
+    }
+}
+
+const OrderBook* JournalExchange::next_book(size_t& slot) {
+    const OrderBook* book = exchange.next_book(slot);
+    if (book != nullptr) ++rows;
+    return book;
+}
+
+size_t JournalExchange::advance(size_t count, size_t history, std::vector<OrderBook>& books) {
+    size_t read = exchange.advance(count, history, books);
+    rows += read;
+    return read;
+}
+
+void JournalExchange::getFills(std::vector<Order>& fills) {
+    exchange.getFills(fills);
+    for (const auto& fill : fills) {
+        writer.record(exchange.getTimeStamp(), rows, JournalEvent::FILL, fill.side, fill.price, fill.amount,
+                      fill.orderId);
+    }
+}
+
+void JournalExchange::cancelOrders() {
+    writer.record(exchange.getTimeStamp(), rows, JournalEvent::CANCEL_ALL, 0, 0, 0, 0);
+    exchange.cancelOrders();
+}
+
+void JournalExchange::quote(OrderId order_id, OrderSide side, const double& price, const double& amount) {
+    writer.record(exchange.getTimeStamp(), rows, JournalEvent::QUOTE, side, price, amount, order_id);
+    exchange.quote(order_id, side, price, amount);
+}
+
+void JournalExchange::market(OrderId order_id, OrderSide side, const double& price, const double& amount) {
+    writer.record(exchange.getTimeStamp(), rows, JournalEvent::MARKET, side, price, amount, order_id);
+    exchange.market(order_id, side, price, amount);
+}
+
+void JournalExchange::amend(OrderId order_id, OrderSide side, const double& price, const double& amount) {
+    writer.record(exchange.getTimeStamp(), rows, JournalEvent::AMEND, side, price, amount, order_id);
+    exchange.amend(order_id, side, price, amount);
+}
+
+void JournalExchange::cancel(OrderId order_id, OrderSide side) {
+    writer.record(exchange.getTimeStamp(), rows, JournalEvent::CANCEL, side, 0, 0, order_id);
+    exchange.cancel(order_id, side);
+}
+
+void JournalExchange::submit(const std::vector<Order>& batch) {
+    const long long now = exchange.getTimeStamp();
+    writer.record(now, rows, JournalEvent::BATCH, 0, 0, static_cast<double>(batch.size()), 0);
+    for (const auto& order : batch) {
+        JournalEvent event = order.state == OrderState::CANCELLED ? JournalEvent::CANCEL
+                             : order.state == OrderState::AMEND ? JournalEvent::AMEND
+                             : order.is_taker ? JournalEvent::MARKET : JournalEvent::QUOTE;
+        writer.record(now, rows, event, order.side, order.price, order.amount, order.orderId);
+    }
+    exchange.submit(batch);
+}
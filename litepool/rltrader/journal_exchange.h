@@ -0,0 +1,63 @@
+#pragma once
+#include <string>
+#include "base_exchange.h"
+#include "journal.h"
+
+namespace RLTrader {
+    // Passes everything through to an exchange, journaling resets, the order flow and the fills reported
+    class JournalExchange final : public BaseExchange {
+    public:
+        JournalExchange(BaseExchange& exch, const std::string& filename, int env_id);
+
+        // Resets the exchange and starts a new episode in the journal, with the file, start row and
+        // latency seed a replayed exchange reports
+        void reset() override;
+
+        const OrderBook* next_book(size_t& slot) override;
+
+        void done_read(size_t slot) override { exchange.done_read(slot); }
+
+        [[nodiscard]] long long getTimeStamp() const override { return exchange.getTimeStamp(); }
+
+        void fetchPosition(double& posAmount, double& avgPrice) override { exchange.fetchPosition(posAmount, avgPrice); }
+
+        void getFills(std::vector<Order>& fills) override;
+
+        void cancelOrders() override;
+
+        [[nodiscard]] const OrderSlots& getBidOrders() const override { return exchange.getBidOrders(); }
+
+        [[nodiscard]] const OrderSlots& getAskOrders() const override { return exchange.getAskOrders(); }
+
+        [[nodiscard]] std::vector<Order> getUnackedOrders() const override { return exchange.getUnackedOrders(); }
+
+        void quote(OrderId order_id, OrderSide side, const double& price, const double& amount) override;
+
+        void market(OrderId order_id, OrderSide side, const double& price, const double& amount) override;
+
+        void amend(OrderId order_id, OrderSide side, const double& price, const double& amount) override;
+
+        void cancel(OrderId order_id, OrderSide side) override;
+
+        // Journals the requests one by one and passes the batch on whole
+        void submit(const std::vector<Order>& batch) override;
+
+        [[nodiscard]] bool isLive(OrderId order_id, OrderSide side) const override { return exchange.isLive(order_id, side); }
+
+        [[nodiscard]] bool isIdle() const override { return exchange.isIdle(); }
+
+        size_t rowsUntil(long long timestamp) override { return exchange.rowsUntil(timestamp); }
+
+        size_t advance(size_t rows, size_t history, std::vector<OrderBook>& books) override;
+
+        [[nodiscard]] const double* marketSignals() const override { return exchange.marketSignals(); }
+
+        // Writes out what is still buffered
+        void flush() { writer.flush(); }
+
+    private:
+        BaseExchange& exchange;
+        JournalWriter writer;
+        uint64_t rows = 0;  // rows read since the last reset
+    };
+}
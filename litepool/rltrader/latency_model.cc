@@ -0,0 +1,111 @@
+#include "latency_model.h"
+#include <cmath>
+#include <sstream>
+#include <stdexcept>
+
+using namespace RLTrader;
+
+LatencyModel::LatencyModel(long long latency) : latency(latency) {
+    if (latency < 0) {
+        throw std::runtime_error("Latency must not be negative");
+    }
+}
+
+LatencyModel LatencyModel::lognormal(double median, double sigma) {
+    if (median <= 0 || sigma < 0) {
+        throw std::runtime_error("Lognormal latency needs a positive median and a non-negative sigma");
+    }
+
+    LatencyModel model;
+    model.model_kind = Kind::LOGNORMAL;
+    model.log_latency = std::lognormal_distribution<double>(std::log(median), sigma);
+    return model;
+}
+
+LatencyModel LatencyModel::empirical(const std::vector<double>& edges, const std::vector<double>& counts) {
+    if (edges.empty() || edges.size() != counts.size()) {
+        throw std::runtime_error("Empirical latency needs one count per bin edge");
+    }
+
+    double previous = 0;
+    for (double edge : edges) {
+        if (edge < previous) {
+            throw std::runtime_error("Empirical latency bin edges must be non-negative and ascending");
+        }
+        previous = edge;
+    }
+
+    // std::discrete_distribution needs non-negative weights with a positive sum
+    double total = 0;
+    for (double count : counts) {
+        if (!(count >= 0)) {
+            throw std::runtime_error("Empirical latency bin counts must be non-negative");
+        }
+        total += count;
+    }
+    if (total <= 0) {
+        throw std::runtime_error("Empirical latency needs at least one non-empty bin");
+    }
+
+    LatencyModel model;
+    model.model_kind = Kind::EMPIRICAL;
+    model.edges = edges;
+    model.bins = std::discrete_distribution<size_t>(counts.begin(), counts.end());
+    return model;
+}
+
+LatencyModel LatencyModel::parse(const std::string& spec) {
+    auto colon = spec.find(':');
+    std::string kind = colon == std::string::npos ? "constant" : spec.substr(0, colon);
+    std::string args = colon == std::string::npos ? spec : spec.substr(colon + 1);
+
+    try {
+        if (kind == "constant") {
+            return LatencyModel(std::stoll(args));
+        }
+
+        if (kind == "lognormal") {
+            auto split = args.find(':');
+            if (split == std::string::npos) {
+                throw std::runtime_error("Lognormal latency needs a median and a sigma");
+            }
+            return lognormal(std::stod(args.substr(0, split)), std::stod(args.substr(split + 1)));
+        }
+
+        if (kind == "empirical") {
+            std::vector<double> edges;
+            std::vector<double> counts;
+            std::stringstream ss(args);
+            std::string bin;
+            while (std::getline(ss, bin, ',')) {
+                auto split = bin.find(':');
+                if (split == std::string::npos) {
+                    throw std::runtime_error("Empirical latency bins are <edge>:<count>");
+                }
+                edges.push_back(std::stod(bin.substr(0, split)));
+                counts.push_back(std::stod(bin.substr(split + 1)));
+            }
+            return empirical(edges, counts);
+        }
+    } catch (const std::logic_error&) {
+        throw std::runtime_error("Invalid latency " + spec);
+    }
+
+    throw std::runtime_error("Unknown latency model " + spec);
+}
+
+long long LatencyModel::sample(std::mt19937& gen) {
+    switch (model_kind) {
+        case Kind::LOGNORMAL:
+            // drop the normal cached from the last draw, so samples depend on the generator's state alone
+            log_latency.reset();
+            return std::llround(log_latency(gen));
+        case Kind::EMPIRICAL: {
+            size_t bin = bins(gen);
+            double low = bin == 0 ? 0 : edges[bin - 1];
+            return std::llround(std::uniform_real_distribution<double>(low, edges[bin])(gen));
+        }
+        default:
+            return latency;
+    }
+}
@@ -0,0 +1,36 @@
+#pragma once
+#include <random>
+#include <string>
+#include <vector>
+
+namespace RLTrader {
+    // One leg of the round trip to the venue, latencies are in timestamp units (microseconds)
+    class LatencyModel {
+    public:
+        enum class Kind { CONSTANT, LOGNORMAL, EMPIRICAL };
+
+        // Same latency every time
+        explicit LatencyModel(long long latency = 0);
+
+        // Lognormal around a median, sigma is the spread of the log latency
+        static LatencyModel lognormal(double median, double sigma);
+
+        // Histogram with bins (edges[i-1], edges[i]] holding counts[i], the first bin starts at zero
+        static LatencyModel empirical(const std::vector<double>& edges, const std::vector<double>& counts);
+
+        // Parses "250", "constant:250", "lognormal:<median>:<sigma>" or "empirical:<edge>:<count>,<edge>:<count>,..."
+        static LatencyModel parse(const std::string& spec);
+
+        [[nodiscard]] Kind kind() const { return model_kind; }
+
+        // Draws a latency
+        long long sample(std::mt19937& gen);
+
+    private:
+        Kind model_kind = Kind::CONSTANT;
+        long long latency = 0;
+        std::lognormal_distribution<double> log_latency;
+        std::vector<double> edges;
+        std::discrete_distribution<size_t> bins;
+    };
+}
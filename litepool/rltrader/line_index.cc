@@ -0,0 +1,147 @@
+#include "line_index.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace RLTrader;
+
+LineIndex::LineIndex(const std::string& filename) {
+    struct stat st{};
+    if (::stat(filename.c_str(), &st) != 0) {
+        throw std::runtime_error("Could not open file " + filename);
+    }
+
+    auto file_size = static_cast<uint64_t>(st.st_size);
+    int64_t file_mtime = static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+    std::string index_file = indexFile(filename);
+
+    if (open(index_file, file_size, file_mtime)) {
+        return;
+    }
+
+    build(filename, owned_offsets, owned_timestamps);
+
+    // publish atomically so that concurrent readers never see a partial index
+    std::random_device rd;
+    std::string temp_file = index_file + "." + std::to_string(::getpid()) + "." + std::to_string(rd());
+    std::ofstream out(temp_file, std::ios::binary | std::ios::trunc);
+    if (out.is_open()) {
+        LineIndexHeader header{};
+        std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+        header.file_size = file_size;
+        header.file_mtime = file_mtime;
+        header.lines = owned_offsets.size();
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(owned_offsets.data()),
+                  static_cast<std::streamsize>(owned_offsets.size() * sizeof(uint64_t)));
+        out.write(reinterpret_cast<const char*>(owned_timestamps.data()),
+                  static_cast<std::streamsize>(owned_timestamps.size() * sizeof(long long)));
+        out.close();
+
+        if (out.good() && std::rename(temp_file.c_str(), index_file.c_str()) == 0
+            && open(index_file, file_size, file_mtime)) {
+            std::vector<uint64_t>().swap(owned_offsets);
+            std::vector<long long>().swap(owned_timestamps);
+            return;
+        }
+        std::remove(temp_file.c_str());
+    }
+
+    // read-only folder, keep the index in memory
+    num_lines = owned_offsets.size();
+    offsets = owned_offsets.data();
+    line_timestamps = owned_timestamps.data();
+}
+
+LineIndex::~LineIndex() {
+    if (mapping != nullptr) {
+        ::munmap(mapping, mapping_size);
+    }
+}
+
+bool LineIndex::open(const std::string& index_file, uint64_t file_size, int64_t file_mtime) {
+    int fd = ::open(index_file.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat st{};
+    if (::fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(LineIndexHeader)) {
+        ::close(fd);
+        return false;
+    }
+
+    void* map = ::mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (map == MAP_FAILED) {
+        return false;
+    }
+
+    const auto* header = static_cast<const LineIndexHeader*>(map);
+    if (std::memcmp(header->magic, MAGIC, sizeof(MAGIC)) != 0
+        || header->file_size != file_size
+        || header->file_mtime != file_mtime
+        || sizeof(LineIndexHeader) + header->lines * (sizeof(uint64_t) + sizeof(long long))
+           != static_cast<size_t>(st.st_size)) {
+        ::munmap(map, static_cast<size_t>(st.st_size));
+        return false;
+    }
+
+    mapping = map;
+    mapping_size = static_cast<size_t>(st.st_size);
+    num_lines = header->lines;
+    offsets = reinterpret_cast<const uint64_t*>(static_cast<const char*>(map) + sizeof(LineIndexHeader));
+    line_timestamps = reinterpret_cast<const long long*>(offsets + num_lines);
+    return true;
+}
+
+void LineIndex::build(const std::string& filename, std::vector<uint64_t>& line_offsets,
+                      std::vector<long long>& timestamps) const {
+    std::ifstream in(filename, std::ios::binary);
+    if (!in.is_open()) {
+        throw std::runtime_error("Could not open file " + filename);
+    }
+
+    std::string line;
+    if (!std::getline(in, line) || in.eof()) {
+        throw std::runtime_error("Failed to read header line");
+    }
+    size_t values = static_cast<size_t>(std::count(line.begin(), line.end(), ','));
+
+    line_offsets.clear();
+    timestamps.clear();
+    uint64_t position = line.size() + 1;
+    while (std::getline(in, line)) {
+        if (isRow(line, values)) {
+            line_offsets.push_back(position);
+            timestamps.push_back(std::strtoll(line.c_str(), nullptr, 10));
+        }
+        position += line.size() + 1;
+    }
+}
+
+bool LineIndex::isRow(const std::string& line, size_t values) {
+    const char* cursor = line.c_str();
+    char* end = nullptr;
+    std::strtoll(cursor, &end, 10);
+    if (end == cursor || *end != ',') {
+        return false;
+    }
+
+    size_t count = 0;
+    cursor = end;
+    while (*cursor == ',' && count < values) {
+        std::strtod(cursor + 1, &end);
+        if (end == cursor + 1) return false;
+        ++count;
+        cursor = end;
+    }
+    return count == values && *cursor != ',';
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace RLTrader {
+    // Byte offsets and timestamps of the rows of a csv file, the header line and malformed lines excluded, so
+    // line n of the index is row n of every reader of the file. The sidecar holds the offsets, then the timestamps.
+    struct LineIndexHeader {
+        char magic[8];
+        uint64_t file_size;
+        int64_t file_mtime;
+        uint64_t lines;
+    };
+
+    class LineIndex {
+    public:
+        static constexpr char MAGIC[8] = {'L', 'P', 'O', 'F', 'F', 'S', '0', '3'};
+
+        // Opens the sidecar index next to the file, building it first if it is missing or stale
+        explicit LineIndex(const std::string& filename);
+        ~LineIndex();
+
+        LineIndex(const LineIndex&) = delete;
+        LineIndex& operator=(const LineIndex&) = delete;
+
+        [[nodiscard]] size_t lines() const { return num_lines; }
+
+        [[nodiscard]] uint64_t offset(size_t line) const { return offsets[line]; }
+
+        // Timestamp column, lines() long, so rows can be found by time without reading the csv file
+        [[nodiscard]] const long long* timestamps() const { return line_timestamps; }
+
+        static std::string indexFile(const std::string& filename) { return filename + ".offsets"; }
+
+    private:
+        bool open(const std::string& index_file, uint64_t file_size, int64_t file_mtime);
+        void build(const std::string& filename, std::vector<uint64_t>& line_offsets,
+                   std::vector<long long>& timestamps) const;
+
+        // Whether a line holds a timestamp and values numbers, the rule the csv readers skip lines by
+        static bool isRow(const std::string& line, size_t values);
+
+        void* mapping = nullptr;
+        size_t mapping_size = 0;
+        size_t num_lines = 0;
+        const uint64_t* offsets = nullptr;
+        const long long* line_timestamps = nullptr;
+        std::vector<uint64_t> owned_offsets;
+        std::vector<long long> owned_timestamps;
+    };
+}
@@ -7,10 +7,10 @@
 using namespace RLTrader;
 
 MarketSignalBuilder::MarketSignalBuilder()
-              :previous_bid_prices(30),
-               previous_ask_prices(30),
-               previous_bid_amounts(30),
-               previous_ask_amounts(30),
+              :previous_bid_prices(HISTORY_ROWS),
+               previous_ask_prices(HISTORY_ROWS),
+               previous_bid_amounts(HISTORY_ROWS),
+               previous_ask_amounts(HISTORY_ROWS),
                previous_price_signal{},
                raw_price_diff_signals(std::make_unique<price_signal_repository>()),                      // price
                raw_spread_signals(std::make_unique<spread_signal_repository>()),                         // spread
@@ -19,6 +19,27 @@ MarketSignalBuilder::MarketSignalBuilder()
     
 }
 
+void MarketSignalBuilder::snapshot(Snapshot& snap) const {
+    previous_bid_prices.snapshot(snap.previous_bid_prices);
+    previous_ask_prices.snapshot(snap.previous_ask_prices);
+    previous_bid_amounts.snapshot(snap.previous_bid_amounts);
+    previous_ask_amounts.snapshot(snap.previous_ask_amounts);
+    snap.previous_price_signal = previous_price_signal;
+    snap.price_diff_signals = *raw_price_diff_signals;
+    snap.spread_signals = *raw_spread_signals;
+    snap.volume_signals = *raw_volume_signals;
+}
+
+void MarketSignalBuilder::restore(const Snapshot& snap) {
+    previous_bid_prices.restore(snap.previous_bid_prices);
+    previous_ask_prices.restore(snap.previous_ask_prices);
+    previous_bid_amounts.restore(snap.previous_bid_amounts);
+    previous_ask_amounts.restore(snap.previous_ask_amounts);
+    previous_price_signal = snap.previous_price_signal;
+    *raw_price_diff_signals = snap.price_diff_signals;
+    *raw_spread_signals = snap.spread_signals;
+    *raw_volume_signals = snap.volume_signals;
+}
 
 void cumulative_prod_sum(const FixedVector<double, 20>& first, const FixedVector<double, 20>& second,
                                         FixedVector<double, 20>& result) {
@@ -55,7 +76,7 @@ double micro_price(const double& bid_price, const double& ask_price,
     return (bid_price * ask_size + ask_price * bid_size) / (bid_size + ask_size);
 }
 
-std::vector<double> MarketSignalBuilder::add_book(OrderBook& book) {
+std::vector<double> MarketSignalBuilder::add_book(const OrderBook& book) {
     compute_signals(book);
 
     std::vector<double> retval;
@@ -136,10 +157,10 @@ MarketSignalBuilder::compute_lagged_ofi(const price_signal_repository& repo,
     auto current_bid_size_5 = cum_bid_sizes[5];
     auto current_ask_size_5 = cum_ask_sizes[5];
 
-    auto lagged_bid_prices = previous_bid_prices.get(previous_bid_prices.get_lagged_row(lag));
-    auto lagged_ask_prices = previous_ask_prices.get(previous_ask_prices.get_lagged_row(lag));
-    auto lagged_bid_sizes = previous_bid_amounts.get(previous_bid_amounts.get_lagged_row(lag));
-    auto lagged_ask_sizes = previous_ask_amounts.get(previous_ask_amounts.get_lagged_row(lag));
+    auto lagged_bid_prices = previous_bid_prices.get(lag);
+    auto lagged_ask_prices = previous_ask_prices.get(lag);
+    auto lagged_bid_sizes = previous_bid_amounts.get(lag);
+    auto lagged_ask_sizes = previous_ask_amounts.get(lag);
 
     FixedVector<double, 20> previous_cum_bid_sizes;
     FixedVector<double, 20> previous_cum_ask_sizes;
@@ -103,9 +103,29 @@ namespace RLTrader {
 
 class MarketSignalBuilder {
 public:
+    static constexpr size_t NUM_SIGNALS = (sizeof(price_signal_repository) + sizeof(spread_signal_repository)
+                                           + sizeof(volume_signal_repository)) / sizeof(double);
+    static constexpr u_int HISTORY_ROWS = 30;  // books before the current one the lagged signals look back over
+
+    // Flat copy of the builder's history
+    struct Snapshot {
+        TemporalTable::Snapshot previous_bid_prices;
+        TemporalTable::Snapshot previous_ask_prices;
+        TemporalTable::Snapshot previous_bid_amounts;
+        TemporalTable::Snapshot previous_ask_amounts;
+        price_signal_repository previous_price_signal;
+        price_signal_repository price_diff_signals;
+        spread_signal_repository spread_signals;
+        volume_signal_repository volume_signals;
+    };
+
     explicit MarketSignalBuilder();
 
-    std::vector<double> add_book(OrderBook& lob);
+    std::vector<double> add_book(const OrderBook& lob);
+
+    void snapshot(Snapshot& snap) const;
+
+    void restore(const Snapshot& snap);
 
 
 private:
@@ -0,0 +1,61 @@
+#include "merged_reader.h"
+#include <stdexcept>
+
+using namespace RLTrader;
+
+MergedReader::MergedReader(std::vector<std::unique_ptr<BaseReader>> sources)
+    :readers(std::move(sources)), books(readers.size()), primed(readers.size(), false) {
+    if (readers.empty()) {
+        throw std::runtime_error("Merged reader needs at least one reader");
+    }
+}
+
+void MergedReader::reset() {
+    readers[0]->reset();
+    start();
+}
+
+void MergedReader::seek(size_t start_row) {
+    readers[0]->seek(start_row);
+    start();
+}
+
+void MergedReader::start() {
+    long long start_time = readers[0]->getTimeStamp();
+    for (size_t ii = 1; ii < readers.size(); ++ii) {
+        readers[ii]->seek(readers[ii]->rowAt(start_time));
+    }
+
+    pending = decltype(pending)();
+    for (size_t ii = 0; ii < readers.size(); ++ii) {
+        primed[ii] = false;
+        pending.emplace(readers[ii]->getTimeStamp(), ii);
+    }
+    this->advance();
+}
+
+void MergedReader::advance() {
+    if (!hasNext()) {
+        throw std::out_of_range("No more elements");
+    }
+
+    // readers sit on their next undelivered row, the earliest one is applied to its book
+    auto [next_timestamp, source] = pending.top();
+    pending.pop();
+    current = source;
+    timestamp = next_timestamp;
+
+    auto& reader = *readers[source];
+    row = reader.getRow();
+    if (primed[source]) {
+        reader.patchBook(books[source]);
+    } else {
+        reader.toBook(books[source]);
+        primed[source] = true;
+    }
+
+    if (reader.hasNext()) {
+        reader.advance();
+        pending.emplace(reader.getTimeStamp(), source);
+    }
+}
@@ -0,0 +1,64 @@
+#pragma once
+#include <functional>
+#include <memory>
+#include <queue>
+#include <utility>
+#include <vector>
+#include "base_reader.h"
+
+namespace RLTrader {
+    // Replays several instruments in timestamp order, keeping one book per instrument.
+    // Library only for now: SimExchange and the env replay a single instrument and no config key builds one.
+    class MergedReader final : public BaseReader {
+    public:
+        explicit MergedReader(std::vector<std::unique_ptr<BaseReader>> readers);
+
+        // Moves the first instrument to a random start and the others to its time
+        void reset() override;
+
+        // Moves the first instrument to start_row of its file and every other one to its first row at or after
+        // that row's time, so the episode starts at the same time on every instrument
+        void seek(size_t start_row) override;
+
+        // Row of the first instrument
+        [[nodiscard]] size_t rowAt(long long timestamp) override { return readers[0]->rowAt(timestamp); }
+
+        bool hasNext() override { return !pending.empty(); }
+
+        void advance() override;
+
+        // Row of the current instrument in its own file
+        [[nodiscard]] size_t getRow() const override { return row; }
+
+        [[nodiscard]] long long getTimeStamp() const override { return timestamp; }
+
+        [[nodiscard]] double getBestBidPrice() const override { return books[current].bid_prices[0]; }
+
+        [[nodiscard]] double getBestAskPrice() const override { return books[current].ask_prices[0]; }
+
+        // Copies the book of the instrument that just ticked
+        void toBook(OrderBook& book) const override { book = books[current]; }
+
+        // Instrument of the current row
+        [[nodiscard]] size_t source() const { return current; }
+
+        [[nodiscard]] size_t instruments() const { return readers.size(); }
+
+        [[nodiscard]] const OrderBook& book(size_t instrument) const { return books[instrument]; }
+
+    private:
+        // Seeks the other instruments to the first one's time, queues the row every reader is positioned on
+        // and delivers the earliest one
+        void start();
+
+        using Event = std::pair<long long, size_t>;
+
+        std::vector<std::unique_ptr<BaseReader>> readers;
+        std::vector<OrderBook> books;
+        std::vector<bool> primed;   // the book already holds a row, so later rows are patched in
+        std::priority_queue<Event, std::vector<Event>, std::greater<>> pending;
+        size_t current = 0;
+        long long timestamp = 0;
+        size_t row = 0;
+    };
+}
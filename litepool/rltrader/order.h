@@ -1,8 +1,8 @@
 #pragma once
 
-#include <string>
-
 namespace RLTrader {
+    using OrderId = long long;
+
     enum class OrderState {
         NEW = 1,
         NEW_ACK = 2,
@@ -21,11 +21,20 @@ namespace RLTrader {
     struct Order
     {
         bool is_taker;
-        std::string orderId;
+        OrderId orderId;
         OrderSide side;
         double price;
         double amount;
         OrderState state;
         long long microSecond;
     };
+
+    // Part of a taker order filled at one book level
+    struct LevelFill
+    {
+        OrderId orderId;
+        OrderSide side;
+        double price;
+        double amount;
+    };
 }
\ No newline at end of file
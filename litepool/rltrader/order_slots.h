@@ -0,0 +1,142 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <stdexcept>
+#include "order.h"
+
+namespace RLTrader {
+    // Fixed capacity order storage, an order lives in the first free slot from its id.
+    // Erased slots stay marked until the chain past them ends, so lookups stop at the first never used slot.
+    class OrderSlots {
+    public:
+        static constexpr size_t CAPACITY = 64;
+
+        template <typename Slots, typename Value>
+        class Iterator {
+        public:
+            Iterator(Slots* owner, size_t slot) : slots(owner), index(slot) { skip(); }
+
+            Value& operator*() const { return slots->orders[index]; }
+            Value* operator->() const { return &slots->orders[index]; }
+
+            Iterator& operator++() {
+                ++index;
+                skip();
+                return *this;
+            }
+
+            bool operator!=(const Iterator& other) const { return index != other.index; }
+
+        private:
+            void skip() {
+                while (index < CAPACITY && slots->state[index] != USED) ++index;
+            }
+
+            Slots* slots;
+            size_t index;
+        };
+
+        using iterator = Iterator<OrderSlots, Order>;
+        using const_iterator = Iterator<const OrderSlots, const Order>;
+
+        iterator begin() { return {this, 0}; }
+        iterator end() { return {this, CAPACITY}; }
+        [[nodiscard]] const_iterator begin() const { return {this, 0}; }
+        [[nodiscard]] const_iterator end() const { return {this, CAPACITY}; }
+
+        [[nodiscard]] size_t size() const { return count; }
+        [[nodiscard]] bool empty() const { return count == 0; }
+
+        // Slot of an order held here, stable until it is erased
+        [[nodiscard]] size_t slotOf(const Order& order) const { return static_cast<size_t>(&order - orders.data()); }
+
+        [[nodiscard]] Order* find(OrderId id) {
+            size_t slot = slotFor(id);
+            return slot < CAPACITY ? &orders[slot] : nullptr;
+        }
+
+        [[nodiscard]] const Order* find(OrderId id) const {
+            size_t slot = slotFor(id);
+            return slot < CAPACITY ? &orders[slot] : nullptr;
+        }
+
+        // Stores the order, replacing the one with the same id
+        Order& insert(const Order& order) {
+            // one probe finds either the order or the end of its chain, a new order takes the first hole on the way
+            size_t slot = home(order.orderId);
+            size_t hole = CAPACITY;
+            for (size_t probe = 0; probe < CAPACITY && state[slot] != FREE; ++probe) {
+                if (state[slot] == USED && orders[slot].orderId == order.orderId) {
+                    orders[slot] = order;
+                    return orders[slot];
+                }
+                if (state[slot] == ERASED && hole == CAPACITY) hole = slot;
+                slot = (slot + 1) % CAPACITY;
+            }
+
+            if (hole == CAPACITY) {
+                if (state[slot] != FREE) {
+                    throw std::runtime_error("Too many resting orders");
+                }
+                hole = slot;
+            }
+            state[hole] = USED;
+            ++count;
+            orders[hole] = order;
+            return orders[hole];
+        }
+
+        bool erase(OrderId id) {
+            size_t slot = slotFor(id);
+            if (slot == CAPACITY) return false;
+            release(slot);
+            return true;
+        }
+
+        void erase(const Order& order) {
+            size_t slot = slotOf(order);
+            if (state[slot] == USED) release(slot);
+        }
+
+        void clear() {
+            state.fill(FREE);
+            count = 0;
+        }
+
+    private:
+        // FREE slots were never used since the last clear and end a probe, ERASED ones keep it going
+        enum SlotState : unsigned char { FREE = 0, USED, ERASED };
+
+        static size_t home(OrderId id) { return static_cast<size_t>(id) % CAPACITY; }
+
+        // Slot holding id, CAPACITY if there is none
+        [[nodiscard]] size_t slotFor(OrderId id) const {
+            size_t slot = home(id);
+            for (size_t probe = 0; probe < CAPACITY && state[slot] != FREE; ++probe) {
+                if (state[slot] == USED && orders[slot].orderId == id) return slot;
+                slot = (slot + 1) % CAPACITY;
+            }
+            return CAPACITY;
+        }
+
+        void release(size_t slot) {
+            --count;
+            if (count == 0) {
+                state.fill(FREE);
+                return;
+            }
+
+            // a slot followed by a free one ends no chain, so it and the erased slots before it are free again
+            state[slot] = ERASED;
+            if (state[(slot + 1) % CAPACITY] != FREE) return;
+            for (size_t probe = 0; probe < CAPACITY && state[slot] == ERASED; ++probe) {
+                state[slot] = FREE;
+                slot = (slot + CAPACITY - 1) % CAPACITY;
+            }
+        }
+
+        std::array<Order, CAPACITY> orders{};
+        std::array<SlotState, CAPACITY> state{};
+        size_t count = 0;
+    };
+}
@@ -11,5 +11,15 @@ namespace  RLTrader {
         FixedVector<double, MAX_LEVELS> ask_prices;
         FixedVector<double, MAX_LEVELS> ask_sizes;
 
+        // Zeroes the levels from depth on, so a book refilled from a shallower file keeps none of the deeper one's
+        void clearFrom(size_t depth) {
+            for (size_t level = depth; level < MAX_LEVELS; ++level) {
+                bid_prices[level] = 0;
+                bid_sizes[level] = 0;
+                ask_prices[level] = 0;
+                ask_sizes[level] = 0;
+            }
+        }
+
     };
 }
@@ -0,0 +1,99 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+#include "order.h"
+
+namespace RLTrader {
+    // Requests in flight per order id for one side, open addressed so scheduling and isLive
+    // look an order up instead of walking the timing wheel. It grows by doubling and is reused after that.
+    class PendingTable {
+    public:
+        struct Entry {
+            OrderId id = 0;
+            long long due = 0;    // latest due time of the requests in flight
+            size_t requests = 0;  // requests in flight, an empty slot has none
+            size_t news = 0;      // new orders among them
+        };
+
+        explicit PendingTable(size_t slots = 64) {
+            size_t capacity = 1;
+            while (capacity < slots) capacity <<= 1;
+            entries.assign(capacity, Entry{});
+        }
+
+        [[nodiscard]] size_t size() const { return count; }
+
+        [[nodiscard]] const Entry* find(OrderId id) const {
+            const Entry& entry = entries[locate(id)];
+            return entry.requests != 0 ? &entry : nullptr;
+        }
+
+        // Counts a request for order due at due
+        void add(const Order& order, long long due) {
+            if (2 * (count + 1) > entries.size()) grow();
+
+            Entry& entry = entries[locate(order.orderId)];
+            if (entry.requests == 0) {
+                entry = Entry{order.orderId, due, 0, 0};
+                ++count;
+            }
+            entry.due = std::max(entry.due, due);
+            ++entry.requests;
+            if (order.state == OrderState::NEW) ++entry.news;
+        }
+
+        // Uncounts a request for order that came due
+        void remove(const Order& order) {
+            size_t slot = locate(order.orderId);
+            Entry& entry = entries[slot];
+            if (entry.requests == 0) return;
+
+            if (order.state == OrderState::NEW && entry.news > 0) --entry.news;
+            if (--entry.requests == 0) erase(slot);
+        }
+
+        void clear() {
+            entries.assign(entries.size(), Entry{});
+            count = 0;
+        }
+
+    private:
+        [[nodiscard]] size_t home(OrderId id) const { return static_cast<size_t>(id) & (entries.size() - 1); }
+
+        // Slot holding id, or the empty slot that ends its probe
+        [[nodiscard]] size_t locate(OrderId id) const {
+            size_t slot = home(id);
+            while (entries[slot].requests != 0 && entries[slot].id != id) {
+                slot = (slot + 1) & (entries.size() - 1);
+            }
+            return slot;
+        }
+
+        // Empties a slot and shifts back the entries after it whose probe passed it, so no tombstones are left
+        void erase(size_t slot) {
+            const size_t mask = entries.size() - 1;
+            entries[slot] = Entry{};
+            --count;
+            for (size_t next = (slot + 1) & mask; entries[next].requests != 0; next = (next + 1) & mask) {
+                size_t want = home(entries[next].id);
+                if (((next - want) & mask) >= ((next - slot) & mask)) {
+                    entries[slot] = entries[next];
+                    entries[next] = Entry{};
+                    slot = next;
+                }
+            }
+        }
+
+        void grow() {
+            std::vector<Entry> previous(entries.size() * 2);
+            previous.swap(entries);
+            for (const Entry& entry : previous) {
+                if (entry.requests != 0) entries[locate(entry.id)] = entry;
+            }
+        }
+
+        std::vector<Entry> entries;
+        size_t count = 0;
+    };
+}
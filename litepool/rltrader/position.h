@@ -23,6 +23,17 @@ namespace RLTrader {
     };
 
     class Position {
+    public:
+        // Flat copy of the position's state
+        struct Snapshot {
+            double averagePrice;
+            double netAmount;
+            double totalFee;
+            int numOfTrades;
+            double balance;
+            TradeInfo trade_info;
+        };
+
     private:
         BaseInstrument& instrument;
         double averagePrice = 0.0;
@@ -44,5 +55,18 @@ namespace RLTrader {
         [[nodiscard]] double getInitialBalance() const { return initialBalance; }
         [[nodiscard]] long getNumberOfTrades() const { return numOfTrades; }
         TradeInfo& getTradeInfo() { return trade_info; }
+
+        void snapshot(Snapshot& snap) const {
+            snap = Snapshot{averagePrice, netAmount, totalFee, numOfTrades, balance, trade_info};
+        }
+
+        void restore(const Snapshot& snap) {
+            averagePrice = snap.averagePrice;
+            netAmount = snap.netAmount;
+            totalFee = snap.totalFee;
+            numOfTrades = snap.numOfTrades;
+            balance = snap.balance;
+            trade_info = snap.trade_info;
+        }
     };
 }
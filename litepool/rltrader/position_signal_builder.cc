@@ -19,6 +19,20 @@ std::vector<double> PositionSignalBuilder::add_info(const PositionInfo& info, co
     return retval;
 }
 
+void PositionSignalBuilder::snapshot(Snapshot& snap) const {
+    snap.max_inventory_pnl = max_inventory_pnl;
+    snap.max_trading_pnl = max_trading_pnl;
+    snap.previous_signals = *raw_previous_signals;
+    snap.spread_signals = *raw_spread_signals;
+}
+
+void PositionSignalBuilder::restore(const Snapshot& snap) {
+    max_inventory_pnl = snap.max_inventory_pnl;
+    max_trading_pnl = snap.max_trading_pnl;
+    *raw_previous_signals = snap.previous_signals;
+    *raw_spread_signals = snap.spread_signals;
+}
+
 void PositionSignalBuilder::compute_signals(const PositionInfo& info, const double& bid_price, const double& ask_price) {
     position_signal_repository repo;
     position_signal_repository& previous_repo = *raw_previous_signals;
@@ -19,10 +19,21 @@ namespace RLTrader {
     
     class PositionSignalBuilder {
     public:
+        struct Snapshot {
+            double max_inventory_pnl;
+            double max_trading_pnl;
+            position_signal_repository previous_signals;
+            position_signal_repository spread_signals;
+        };
+
         PositionSignalBuilder();
 
         std::vector<double> add_info(const PositionInfo& info, const double& bid_price, const double& ask_price);
 
+        void snapshot(Snapshot& snap) const;
+
+        void restore(const Snapshot& snap);
+
 
     private:
         void compute_signals(const PositionInfo& info, const double& bid_price, const double& ask_price);
@@ -0,0 +1,99 @@
+#pragma once
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace RLTrader {
+    // Runs a batch producer on its own I/O thread, keeping at most depth batches in flight.
+    // Batches are recycled between producer and consumer so steady state does not allocate.
+    template <typename Batch>
+    class Prefetcher {
+    public:
+        // produce fills a batch and returns false once no more batches follow
+        Prefetcher(std::function<bool(Batch&)> produce, size_t depth)
+            :producer(std::move(produce)), capacity(std::max<size_t>(1, depth)), worker([this] { run(); }) {
+        }
+
+        ~Prefetcher() {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                stopping = true;
+            }
+            space_cv.notify_all();
+            worker.join();
+        }
+
+        Prefetcher(const Prefetcher&) = delete;
+        Prefetcher& operator=(const Prefetcher&) = delete;
+
+        // Swaps the next batch into batch, blocking until it is ready; false once the producer is done
+        bool pop(Batch& batch) {
+            std::unique_lock<std::mutex> lock(mutex);
+            ready_cv.wait(lock, [this] { return !ready.empty() || finished; });
+            if (ready.empty()) {
+                if (error) std::rethrow_exception(error);
+                return false;
+            }
+
+            std::swap(batch, ready.front());
+            spare.push_back(std::move(ready.front()));
+            ready.pop_front();
+            lock.unlock();
+            space_cv.notify_one();
+            return true;
+        }
+
+    private:
+        void run() {
+            while (true) {
+                Batch batch;
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    space_cv.wait(lock, [this] { return ready.size() < capacity || stopping; });
+                    if (stopping) return;
+                    if (!spare.empty()) {
+                        batch = std::move(spare.back());
+                        spare.pop_back();
+                    }
+                }
+
+                bool more = false;
+                std::exception_ptr failure;
+                try {
+                    more = producer(batch);
+                } catch (...) {
+                    failure = std::current_exception();
+                }
+
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    if (failure) {
+                        error = failure;
+                    } else {
+                        ready.push_back(std::move(batch));
+                    }
+                    finished = failure || !more;
+                }
+                ready_cv.notify_one();
+                if (failure || !more) return;
+            }
+        }
+
+        std::function<bool(Batch&)> producer;
+        size_t capacity;
+        std::mutex mutex;
+        std::condition_variable ready_cv;
+        std::condition_variable space_cv;
+        std::deque<Batch> ready;
+        std::vector<Batch> spare;
+        std::exception_ptr error;
+        bool finished = false;
+        bool stopping = false;
+        std::thread worker;
+    };
+}
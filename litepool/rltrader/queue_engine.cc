@@ -0,0 +1,64 @@
+#include "queue_engine.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace RLTrader;
+
+double QueueEngine::levelSize(const OrderBook& book, OrderSide side, double price) {
+    const auto& prices = side == OrderSide::BUY ? book.bid_prices : book.ask_prices;
+    const auto& sizes = side == OrderSide::BUY ? book.bid_sizes : book.ask_sizes;
+
+    // bids are sorted down and asks up, so the scan stops at the first level past the price
+    for (size_t ii = 0; ii < OrderBook::MAX_LEVELS && prices[ii] > 0; ++ii) {
+        if (std::abs(prices[ii] - price) <= 0.00001) return sizes[ii];
+        if (side == OrderSide::BUY ? prices[ii] < price : prices[ii] > price) return 0;
+    }
+
+    return -1;
+}
+
+void QueueEngine::join(const Order& order, size_t slot, const OrderBook& book) {
+    auto& spot = spots(order.side)[slot];
+    spot.level = levelSize(book, order.side, order.price);
+    spot.ahead = std::max(0.0, spot.level);
+}
+
+double QueueEngine::onBook(const Order& order, size_t slot, const OrderBook& book, bool prints_drive) {
+    auto& spot = spots(order.side)[slot];
+    double size = levelSize(book, order.side, order.price);
+    if (size < 0) return 0;
+
+    // a level coming into view for the first time is all ahead of the quote
+    if (spot.level < 0) {
+        spot.level = size;
+        spot.ahead = size;
+        return 0;
+    }
+
+    double decrease = spot.level - size;
+    spot.level = size;
+
+    if (prints_drive) {
+        spot.ahead = std::min(spot.ahead, size);
+        return 0;
+    }
+
+    // size leaves a level from the front, what is added joins behind the quote
+    if (decrease <= 0) return 0;
+    spot.ahead -= decrease;
+    if (spot.ahead >= 0) return 0;
+
+    double fill = -spot.ahead;
+    spot.ahead = 0;
+    return fill;
+}
+
+double QueueEngine::onPrint(const Order& order, size_t slot, double amount) {
+    auto& spot = spots(order.side)[slot];
+    spot.ahead -= amount;
+    if (spot.ahead >= 0) return 0;
+
+    double fill = -spot.ahead;
+    spot.ahead = 0;
+    return fill;
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include <array>
+#include "order.h"
+#include "order_slots.h"
+#include "orderbook.h"
+
+namespace RLTrader {
+    // Tracks the visible size queued ahead of each resting quote at its price level.
+    // Quotes live in the exchange's OrderSlots and are addressed here by side and slot.
+    class QueueEngine {
+    public:
+        // Size at price on a side of the book, 0 for a gap inside the visible levels, -1 past them
+        static double levelSize(const OrderBook& book, OrderSide side, double price);
+
+        // A quote joins the back of its level
+        void join(const Order& order, size_t slot, const OrderBook& book);
+
+        // Reads the quote's level in a new row, returns the amount the quote fills from the level shrinking.
+        // When prints drive the queue the book only caps what can still be ahead and never fills.
+        double onBook(const Order& order, size_t slot, const OrderBook& book, bool prints_drive);
+
+        // Applies a print at the quote's price, returns the amount the quote fills
+        double onPrint(const Order& order, size_t slot, double amount);
+
+        // Visible size still ahead of a quote
+        [[nodiscard]] double ahead(OrderSide side, size_t slot) const { return spots(side)[slot].ahead; }
+
+    private:
+        struct Spot {
+            double ahead = 0;   // size in front of the quote
+            double level = -1;  // size of the level when last seen, -1 while the level is past the visible book
+        };
+
+        using Spots = std::array<Spot, OrderSlots::CAPACITY>;
+
+        Spots& spots(OrderSide side) { return side == OrderSide::BUY ? bid_spots : ask_spots; }
+        [[nodiscard]] const Spots& spots(OrderSide side) const { return side == OrderSide::BUY ? bid_spots : ask_spots; }
+
+        Spots bid_spots{};
+        Spots ask_spots{};
+    };
+}
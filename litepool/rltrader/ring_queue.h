@@ -0,0 +1,65 @@
+#pragma once
+#include <cstddef>
+#include <stdexcept>
+#include <vector>
+
+namespace RLTrader {
+    // FIFO over a power of two ring, grows by doubling only when full so steady state pushes never allocate
+    template <typename T>
+    class RingQueue {
+    public:
+        explicit RingQueue(size_t initial_capacity = 256) {
+            size_t capacity = 1;
+            while (capacity < initial_capacity) capacity <<= 1;
+            items.resize(capacity);
+        }
+
+        [[nodiscard]] size_t size() const { return count; }
+        [[nodiscard]] bool empty() const { return count == 0; }
+        [[nodiscard]] size_t capacity() const { return items.size(); }
+
+        void push(const T& value) {
+            if (count == items.size()) grow();
+            items[(head + count) & (items.size() - 1)] = value;
+            ++count;
+        }
+
+        [[nodiscard]] T& front() {
+            if (count == 0) throw std::out_of_range("RingQueue is empty");
+            return items[head];
+        }
+
+        [[nodiscard]] const T& front() const {
+            if (count == 0) throw std::out_of_range("RingQueue is empty");
+            return items[head];
+        }
+
+        void pop() {
+            if (count == 0) throw std::out_of_range("RingQueue is empty");
+            head = (head + 1) & (items.size() - 1);
+            --count;
+        }
+
+        // i-th item from the front
+        [[nodiscard]] const T& operator[](size_t i) const { return items[(head + i) & (items.size() - 1)]; }
+
+        void clear() {
+            head = 0;
+            count = 0;
+        }
+
+    private:
+        void grow() {
+            std::vector<T> larger(items.size() * 2);
+            for (size_t i = 0; i < count; ++i) {
+                larger[i] = std::move(items[(head + i) & (items.size() - 1)]);
+            }
+            items.swap(larger);
+            head = 0;
+        }
+
+        std::vector<T> items;
+        size_t head = 0;
+        size_t count = 0;
+    };
+}
@@ -32,6 +32,8 @@
 
 #include "deribit_exchange.h"
 #include "sim_exchange.h"
+#include "journal_exchange.h"
+#include "episode_sampler.h"
 
 namespace fs = std::filesystem;
 namespace rltrader {
@@ -51,6 +53,21 @@ class RlTraderEnvFns {
                     "foldername"_.Bind(std::string("./train_files/")),
                     "balance"_.Bind(1.0),
                     "start"_.Bind<int>(0),
+                    "shared_data"_.Bind<bool>(false),
+                    "prefetch"_.Bind<int>(0),
+                    "precompute_features"_.Bind<bool>(false),
+                    "trade_fills"_.Bind<bool>(false),
+                    "queue_fills"_.Bind<bool>(false),
+                    "ack_latency"_.Bind(std::string("250")),
+                    "cancel_latency"_.Bind(std::string("250")),
+                    "fill_latency"_.Bind(std::string("0")),
+                    "step_interval"_.Bind<int>(0),
+                    "step_max_rows"_.Bind<int>(1000),
+                    "warmup_rows"_.Bind<int>(0),
+                    "step_bucket"_.Bind<int>(0),
+                    "grid_levels"_.Bind<int>(1),
+                    "grid_profile"_.Bind(std::string("")),
+                    "journal"_.Bind(std::string("")),
                     "max"_.Bind<int>(72000));
   }
 
@@ -98,6 +115,21 @@ class RlTraderEnv : public Env<RlTraderEnvSpec> {
   double balance = 0;
   int start_read = 0;
   int max_read = 0;
+  bool shared_data = false;
+  int prefetch = 0;
+  bool precompute_features = false;
+  bool trade_fills = false;
+  bool queue_fills = false;
+  std::string ack_latency;
+  std::string cancel_latency;
+  std::string fill_latency;
+  int step_interval = 0;
+  int step_max_rows = 0;  // row cap of event and bucketed steps
+  int warmup_rows = 0;
+  int step_bucket = 0;  // bucket length in microseconds, the market signals see one conflated book per bucket
+  int grid_levels = 1;
+  std::string grid_profile;
+  std::string journal;
   long long steps = 0;
   double previous_buy_sell_diff = 0;
   double previous_rpnl = 0;
@@ -105,6 +137,9 @@ class RlTraderEnv : public Env<RlTraderEnvSpec> {
   double previous_fees = 0;
   std::unique_ptr<RLTrader::BaseInstrument> instr_ptr;
   std::unique_ptr<RLTrader::BaseExchange> exchange_ptr;
+  RLTrader::SimExchange* sim_exchange = nullptr;
+  std::unique_ptr<RLTrader::JournalExchange> journal_ptr;
+  std::unique_ptr<RLTrader::EpisodeSampler> sampler;
   std::unique_ptr<RLTrader::Strategy> strategy_ptr;
   std::unique_ptr<RLTrader::EnvAdaptor> adaptor_ptr;
  public:
@@ -121,7 +156,22 @@ class RlTraderEnv : public Env<RlTraderEnvSpec> {
                                               foldername(spec.config["foldername"_]),
                                               balance(spec.config["balance"_]),
                                               start_read(spec.config["start"_]),
-                                              max_read(spec.config["max"_])
+                                              max_read(spec.config["max"_]),
+                                              shared_data(spec.config["shared_data"_]),
+                                              prefetch(spec.config["prefetch"_]),
+                                              precompute_features(spec.config["precompute_features"_]),
+                                              trade_fills(spec.config["trade_fills"_]),
+                                              queue_fills(spec.config["queue_fills"_]),
+                                              ack_latency(spec.config["ack_latency"_]),
+                                              cancel_latency(spec.config["cancel_latency"_]),
+                                              fill_latency(spec.config["fill_latency"_]),
+                                              step_interval(spec.config["step_interval"_]),
+                                              step_max_rows(spec.config["step_max_rows"_]),
+                                              warmup_rows(spec.config["warmup_rows"_]),
+                                              step_bucket(spec.config["step_bucket"_]),
+                                              grid_levels(spec.config["grid_levels"_]),
+                                              grid_profile(spec.config["grid_profile"_]),
+                                              journal(spec.config["journal"_])
   {
 
     RLTrader::BaseInstrument* instr_raw_ptr = nullptr;
@@ -138,16 +188,30 @@ class RlTraderEnv : public Env<RlTraderEnvSpec> {
     if (this->is_prod) {
       exch_raw_ptr = new RLTrader::DeribitExchange(symbol, api_key, api_secret);
     } else {
-      int idx = env_id % 64;
-      std::string filename = foldername + std::to_string(idx + 1) + ".csv";
+      auto catalog = RLTrader::DatasetCatalog::get(foldername);
+      sampler = std::make_unique<RLTrader::EpisodeSampler>(catalog, max_read, start_read);
+      // Reset samples every episode, so the exchange just opens on the catalog's first file
+      const auto& filename = catalog->entries().front().filename;
       std::cout << filename << std::endl;
-      exch_raw_ptr = new RLTrader::SimExchange(filename, 250, start_read, max_read);
+      sim_exchange = new RLTrader::SimExchange(filename, 250, start_read, max_read, shared_data, prefetch,
+                                                 precompute_features, trade_fills, queue_fills);
+      sim_exchange->setLatency(RLTrader::LatencyModel::parse(ack_latency),
+                               RLTrader::LatencyModel::parse(cancel_latency),
+                               RLTrader::LatencyModel::parse(fill_latency), gen_());
+      exch_raw_ptr = sim_exchange;
     }
 
     instr_ptr.reset(instr_raw_ptr);
     exchange_ptr.reset(exch_raw_ptr);
-    strategy_ptr = std::make_unique<RLTrader::Strategy>(*instr_ptr, *exchange_ptr, balance, 20);
-    adaptor_ptr = std::make_unique<RLTrader::EnvAdaptor>(*strategy_ptr, *exchange_ptr);
+    if (!journal.empty()) {
+      journal_ptr = std::make_unique<RLTrader::JournalExchange>(*exchange_ptr, journal, env_id_);
+    }
+    RLTrader::BaseExchange& exchange = journal_ptr ? *journal_ptr : *exchange_ptr;
+    strategy_ptr = std::make_unique<RLTrader::Strategy>(*instr_ptr, exchange, balance, 20);
+    strategy_ptr->setGrid(static_cast<size_t>(std::max(grid_levels, 1)), RLTrader::Strategy::parseProfile(grid_profile));
+    adaptor_ptr = std::make_unique<RLTrader::EnvAdaptor>(*strategy_ptr, exchange);
+    adaptor_ptr->setEventStepping(step_interval, static_cast<size_t>(std::max(step_max_rows, 1)));
+    adaptor_ptr->setBucketStepping(step_bucket, static_cast<size_t>(std::max(step_max_rows, 1)));
   }
 
   void Reset() override {
@@ -156,8 +220,16 @@ class RlTraderEnv : public Env<RlTraderEnvSpec> {
     previous_rpnl = 0;
     previous_upnl = 0;
     previous_fees = 0;
+    if (sampler) {
+      auto episode = sampler->sample(gen_);
+      sim_exchange->setEpisode(episode.filename, episode.start_row);
+    }
     adaptor_ptr->reset();
     isDone = false;
+    // fresh episodes are flat with nothing working, so the warm-up fast-forwards
+    if (warmup_rows > 0) {
+      isDone = !adaptor_ptr->advance(static_cast<size_t>(warmup_rows));
+    }
     WriteState();
   }
 
@@ -217,6 +289,51 @@ class RlTraderEnv : public Env<RlTraderEnvSpec> {
   }
 
   bool IsDone() override { return isDone; }
+
+  // Flat copy of a simulated env, restoring one branches a rollout from that point of the episode
+  struct EnvSnapshot {
+    RLTrader::SimExchange::Snapshot exchange;
+    RLTrader::EnvAdaptor::Snapshot adaptor;
+    long long steps;
+    double previous_buy_sell_diff;
+    double previous_rpnl;
+    double previous_upnl;
+    double previous_fees;
+    bool isDone;
+  };
+
+  void Snapshot(EnvSnapshot& snap) const {
+    if (sim_exchange == nullptr) {
+      throw std::runtime_error("Only simulated envs can be snapshotted");
+    }
+    sim_exchange->snapshot(snap.exchange);
+    adaptor_ptr->snapshot(snap.adaptor);
+    snap.steps = steps;
+    snap.previous_buy_sell_diff = previous_buy_sell_diff;
+    snap.previous_rpnl = previous_rpnl;
+    snap.previous_upnl = previous_upnl;
+    snap.previous_fees = previous_fees;
+    snap.isDone = isDone;
+  }
+
+  // The snapshot must come from the current episode, the exchange throws otherwise
+  void Restore(const EnvSnapshot& snap) {
+    if (sim_exchange == nullptr) {
+      throw std::runtime_error("Only simulated envs can be restored");
+    }
+    // the journal is one linear record of the order flow, a branch would break its row count
+    if (journal_ptr) {
+      throw std::runtime_error("Journaling envs cannot be restored");
+    }
+    sim_exchange->restore(snap.exchange);
+    adaptor_ptr->restore(snap.adaptor);
+    steps = snap.steps;
+    previous_buy_sell_diff = snap.previous_buy_sell_diff;
+    previous_rpnl = snap.previous_rpnl;
+    previous_upnl = snap.previous_upnl;
+    previous_fees = snap.previous_fees;
+    isDone = snap.isDone;
+  }
 };
 
 using RlTraderLitePool = AsyncLitePool<RlTraderEnv>;
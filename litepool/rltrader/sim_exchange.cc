@@ -1,99 +1,276 @@
 #include "sim_exchange.h"
+#include <algorithm>
 #include <vector>
 #include <cassert>
+#include <cmath>
 #include <sstream>
 #include <iostream>
+#include <filesystem>
 #include "orderbook.h"
+#include "market_signal_builder.h"
+#include "csv_reader.h"
+#include "block_reader.h"
+#include "delta_reader.h"
+#include "tick_reader.h"
+#include "dataset_cache.h"
 
 using namespace RLTrader;
 
-std::vector<std::string> SimExchange::bid_price_labels(0);
-std::vector<std::string> SimExchange::ask_price_labels(0);
-std::vector<std::string> SimExchange::bid_size_labels(0);
-std::vector<std::string> SimExchange::ask_size_labels(0);
-bool SimExchange::init = SimExchange::initialize();
-
-bool SimExchange::initialize() {
-	for (int ii = 0; ii < 20; ++ii) {
-		std::ostringstream bid_price_lbl;
-		bid_price_lbl << "bids[" << ii << "].price";
-		std::ostringstream ask_price_lbl;
-		ask_price_lbl << "asks[" << ii << "].price";
-		std::ostringstream bid_amount_lbl;
-		bid_amount_lbl << "bids[" << ii << "].amount";
-		std::ostringstream ask_amount_lbl;
-		ask_amount_lbl << "asks[" << ii << "].amount";
-
-		SimExchange::bid_price_labels.push_back(bid_price_lbl.str());
-		SimExchange::ask_price_labels.push_back(ask_price_lbl.str());
-		SimExchange::bid_size_labels.push_back(bid_amount_lbl.str());
-		SimExchange::ask_size_labels.push_back(ask_amount_lbl.str());
+std::unique_ptr<BaseReader> SimExchange::makeReader(const std::string& filename, int start_read, int max_read,
+                                                    bool shared_data, int prefetch_depth) {
+	if (shared_data) {
+		return std::make_unique<TickReader>(DatasetCache::get(filename), start_read, max_read);
 	}
 
-	return true;
-}
+	auto extension = std::filesystem::path(filename).extension();
+	if (extension == ".bin") {
+		return std::make_unique<TickReader>(filename, start_read, max_read);
+	}
 
-void SimExchange::toBook(const std::unordered_map<std::string, double>& lob, OrderBook& book)  {
-	int ii = 0;
-	for(const auto & bid_price_label : bid_price_labels) {
-		if (lob.find(bid_price_label) != lob.end()) {
-			book.bid_prices[ii] = lob.at(SimExchange::bid_price_labels[ii]);
-			book.ask_prices[ii] = lob.at(SimExchange::ask_price_labels[ii]);
-			book.bid_sizes[ii]= lob.at(SimExchange::bid_size_labels[ii]);
-			book.ask_sizes[ii] = lob.at(SimExchange::ask_size_labels[ii]);
-		}
-		ii++;
+	if (extension == ".blk") {
+		return std::make_unique<BlockReader>(filename, start_read, max_read, prefetch_depth);
 	}
+
+	if (extension == ".dlt") {
+		return std::make_unique<DeltaReader>(filename, start_read, max_read);
+	}
+
+	return std::make_unique<CsvReader>(filename, start_read, max_read, prefetch_depth);
 }
 
-SimExchange::SimExchange(const std::string& filename, long delay, int start_read, int max_read) :dataReader(filename, start_read, max_read), delay(delay) {
+SimExchange::SimExchange(const std::string& filename, long delay, int start_read, int max_read,
+                         bool shared_data, int prefetch_depth, bool precompute_features, bool trade_fills,
+                         bool queue_fills)
+	:dataReader(makeReader(filename, start_read, max_read, shared_data, prefetch_depth)),
+	 filename(filename), start_read(start_read), max_read(max_read), shared_data(shared_data),
+	 prefetch_depth(prefetch_depth), precompute_features(precompute_features),
+	 features(precompute_features ? FeatureStore::get(filename) : nullptr), trade_fills(trade_fills),
+	 trades(trade_fills ? TradeTape::get(TradeTape::tradeFile(filename)) : nullptr),
+	 queue_fills(queue_fills), ack_latency(delay), cancel_latency(delay), fill_latency(0) {
 	bid_quotes.clear();
 	ask_quotes.clear();
 	executions.clear();
+	// reserved up front so walking the book does not allocate
+	walked_levels.reserve(OrderSlots::CAPACITY * OrderBook::MAX_LEVELS);
+	reported_levels.reserve(OrderSlots::CAPACITY * OrderBook::MAX_LEVELS);
+	level_fills.reserve(OrderSlots::CAPACITY * OrderBook::MAX_LEVELS);
 	timed_buffer.clear();
-	dataReader.reset();
+	bid_pending.clear();
+	ask_pending.clear();
+	rows_read = 0;
+	// episodes pick their start on reset, so the reader just opens on its first row
+	dataReader->seek(0);
+	dataReader->toBook(replay_book);
+	rewindTrades();
+	episode_row = dataReader->getRow();
 }
 
 
 void SimExchange::reset() {
-	this->dataReader.reset();
+	if (this->episode_file.empty()) {
+		this->dataReader->reset();
+	} else {
+		if (this->episode_file != this->filename) {
+			this->dataReader = makeReader(this->episode_file, start_read, max_read, shared_data, prefetch_depth);
+			this->filename = this->episode_file;
+			if (this->precompute_features) {
+				this->features = FeatureStore::get(this->filename);
+			}
+			if (this->trade_fills) {
+				this->trades = TradeTape::get(TradeTape::tradeFile(this->filename));
+			}
+		}
+		this->dataReader->seek(this->episode_start);
+		this->episode_file.clear();
+	}
+	this->dataReader->toBook(this->replay_book);
 	this->executions.clear();
+	this->walked_levels.clear();
+	this->reported_levels.clear();
+	this->level_fills.clear();
 	this->bid_quotes.clear();
 	this->ask_quotes.clear();
 	this->timed_buffer.clear();
+	this->bid_pending.clear();
+	this->ask_pending.clear();
+	this->rows_read = 0;
+	this->rewindTrades();
+
+	// every episode reseeds its latencies, so one can be replayed from its seed alone
+	this->episode_seed = this->seed_pinned ? this->pinned_seed : static_cast<unsigned>(this->latency_gen());
+	this->seed_pinned = false;
+	this->latency_gen.seed(this->episode_seed);
+	this->episode_row = this->dataReader->getRow();
+}
+
+void SimExchange::rewindTrades() {
+	this->bid_printed.fill(0);
+	this->ask_printed.fill(0);
+	this->next_trade = this->trades ? this->trades->after(this->dataReader->getTimeStamp()) : 0;
+}
+
+const double* SimExchange::marketSignals() const {
+	// stored rows carry history from before the episode, so its first rows are built live from an empty history
+	if (!this->features || this->rows_read <= MarketSignalBuilder::HISTORY_ROWS) return nullptr;
+	return this->features->row(this->dataReader->getRow());
+}
+
+void SimExchange::setLatency(const LatencyModel& ack, const LatencyModel& cancel, const LatencyModel& fill,
+                             unsigned seed) {
+	this->ack_latency = ack;
+	this->cancel_latency = cancel;
+	this->fill_latency = fill;
+	this->latency_gen.seed(seed);
+}
+
+void SimExchange::setEpisode(const std::string& file, size_t start_row) {
+	this->episode_file = file;
+	this->episode_start = start_row;
+}
+
+void SimExchange::setEpisodeSeed(unsigned seed) {
+	this->seed_pinned = true;
+	this->pinned_seed = seed;
 }
 
-bool SimExchange::next_read(size_t& slot, OrderBook& book) {
-    if (this->dataReader.hasNext()) {
-        this->dataReader.next();
+bool SimExchange::getEpisode(EpisodeStart& episode) const {
+	episode.filename = this->filename;
+	episode.start_row = this->episode_row;
+	episode.seed = this->episode_seed;
+	return true;
+}
+
+const OrderBook* SimExchange::next_book(size_t& slot) {
+    if (this->rows_read < static_cast<size_t>(this->max_read) && this->dataReader->hasNext()) {
+        this->dataReader->advance();
+        ++this->rows_read;
     	slot = 0;
-    	toBook(this->dataReader.current().data, book);
+    	this->dataReader->patchBook(this->replay_book);
         this->execute();
     } else {
-        return false;
+        return nullptr;
     }
 
-    return true;
+    return &this->replay_book;
+}
+
+void SimExchange::snapshot(Snapshot& snap) const {
+	if (this->timed_buffer.size() > MAX_PENDING || this->executions.size() > MAX_EXECUTIONS
+	    || this->walked_levels.size() + this->reported_levels.size() > MAX_LEVEL_FILLS) {
+		throw std::runtime_error("Too many orders in flight to snapshot");
+	}
+
+	snap.file_hash = std::hash<std::string>{}(this->filename);
+	snap.episode_row = this->episode_row;
+	snap.row = this->dataReader->getRow();
+	snap.rows_read = this->rows_read;
+	snap.next_trade = this->next_trade;
+	snap.bid_quotes = this->bid_quotes;
+	snap.ask_quotes = this->ask_quotes;
+	snap.bid_printed = this->bid_printed;
+	snap.ask_printed = this->ask_printed;
+	snap.bid_filled = this->bid_filled;
+	snap.ask_filled = this->ask_filled;
+	snap.queue = this->queue;
+	snap.latency_gen = this->latency_gen;
+	snap.released_bucket = this->timed_buffer.releasedBucket();
+	snap.num_pending = 0;
+	this->timed_buffer.forEachScheduled([&snap](long long due, const Order& order) {
+		snap.pending_due[snap.num_pending] = due;
+		snap.pending[snap.num_pending++] = order;
+	});
+	snap.num_executions = this->executions.size();
+	std::copy(this->executions.begin(), this->executions.end(), snap.executions.begin());
+	snap.num_walked = this->walked_levels.size();
+	snap.num_reported = this->reported_levels.size();
+	auto levels = std::copy(this->walked_levels.begin(), this->walked_levels.end(), snap.levels.begin());
+	std::copy(this->reported_levels.begin(), this->reported_levels.end(), levels);
+}
+
+void SimExchange::restore(const Snapshot& snap) {
+	if (snap.file_hash != std::hash<std::string>{}(this->filename) || snap.episode_row != this->episode_row) {
+		throw std::runtime_error("Snapshot was taken in another episode");
+	}
+
+	this->dataReader->seek(snap.row);
+	this->dataReader->toBook(this->replay_book);
+	this->rows_read = snap.rows_read;
+	this->next_trade = snap.next_trade;
+	this->bid_quotes = snap.bid_quotes;
+	this->ask_quotes = snap.ask_quotes;
+	this->bid_printed = snap.bid_printed;
+	this->ask_printed = snap.ask_printed;
+	this->bid_filled = snap.bid_filled;
+	this->ask_filled = snap.ask_filled;
+	this->queue = snap.queue;
+	this->latency_gen = snap.latency_gen;
+	this->timed_buffer.restart(snap.released_bucket);
+	this->bid_pending.clear();
+	this->ask_pending.clear();
+	for (size_t ii = 0; ii < snap.num_pending; ++ii) {
+		const Order& order = snap.pending[ii];
+		this->timed_buffer.schedule(snap.pending_due[ii], order);
+		if (order.state != OrderState::FILLED) {
+			(order.side == OrderSide::BUY ? this->bid_pending : this->ask_pending).add(order, snap.pending_due[ii]);
+		}
+	}
+	this->executions.assign(snap.executions.begin(), snap.executions.begin() + snap.num_executions);
+	auto levels = snap.levels.begin() + snap.num_walked;
+	this->walked_levels.assign(snap.levels.begin(), levels);
+	this->reported_levels.assign(levels, levels + snap.num_reported);
+	this->level_fills.clear();
+}
+
+bool SimExchange::isIdle() const {
+	return this->bid_quotes.empty() && this->ask_quotes.empty()
+	       && this->timed_buffer.empty() && this->executions.empty();
+}
+
+size_t SimExchange::rowsUntil(long long timestamp) {
+	size_t row = this->dataReader->rowAt(timestamp);
+	size_t current = this->dataReader->getRow();
+	return row > current ? row - current : 1;
+}
+
+size_t SimExchange::advance(size_t rows, size_t history, std::vector<OrderBook>& books) {
+	books.clear();
+	rows = std::min(rows, static_cast<size_t>(this->max_read) - this->rows_read);
+
+	// rows nobody looks at are skipped without building their books
+	size_t ahead = rows > history ? rows - history : 0;
+	size_t read = this->dataReader->skip(ahead);
+	if (read > 0) this->dataReader->toBook(this->replay_book);
+
+	if (read == ahead) {
+		for (; read < rows && this->dataReader->hasNext(); ++read) {
+			this->dataReader->advance();
+			this->dataReader->patchBook(this->replay_book);
+			books.push_back(this->replay_book);
+		}
+	}
+
+	this->rows_read += read;
+	// no quotes were there for the skipped prints to hit
+	if (read > 0) this->rewindTrades();
+	return read;
 }
 
 void SimExchange::done_read(size_t slot) {
 	// no ops
 }
 
-const std::map<std::string, Order>& SimExchange::getBidOrders() const {
+const OrderSlots& SimExchange::getBidOrders() const {
 	return this->bid_quotes;
 }
 
-const std::map<std::string, Order>& SimExchange::getAskOrders() const {
+const OrderSlots& SimExchange::getAskOrders() const {
 	return this->ask_quotes;
 }
 
 std::vector<Order> SimExchange::getUnackedOrders() const {
 	std::vector<Order> retval;
-	
-	for (auto& [timestamp, orders] : this->timed_buffer) {
-		retval.insert(retval.end(), orders.begin(), orders.end());
-	}
+	retval.reserve(this->timed_buffer.size());
+	this->timed_buffer.forEach([&retval](const Order& order) { retval.push_back(order); });
 
 	return retval;
 }
@@ -103,10 +280,10 @@ void SimExchange::fetchPosition(double &posAmount, double &avgPrice) {
 	avgPrice = 0;
 }
 
-void SimExchange::quote(std::string order_id, OrderSide side, const double& price, const double& amount) {
+void SimExchange::quote(OrderId order_id, OrderSide side, const double& price, const double& amount) {
 	Order order{};
 	order.is_taker = false;
-	order.microSecond = this->dataReader.getTimeStamp();
+	order.microSecond = this->dataReader->getTimeStamp();
 	order.amount = amount;
 	order.orderId = order_id;
 	order.price = price;
@@ -115,10 +292,10 @@ void SimExchange::quote(std::string order_id, OrderSide side, const double& pric
 	this->addToBuffer(order);
 }
 
-void SimExchange::market(std::string order_id, OrderSide side, const double &price, const double &amount) {
+void SimExchange::market(OrderId order_id, OrderSide side, const double &price, const double &amount) {
 	Order order{};
 	order.is_taker = true;
-	order.microSecond = this->dataReader.getTimeStamp();
+	order.microSecond = this->dataReader->getTimeStamp();
 	order.amount = amount;
 	order.orderId = order_id;
 	order.price = price;
@@ -127,105 +304,161 @@ void SimExchange::market(std::string order_id, OrderSide side, const double &pri
         this->addToBuffer(order);
 }
 
+void SimExchange::amend(OrderId order_id, OrderSide side, const double& price, const double& amount) {
+	Order order{};
+	order.is_taker = false;
+	order.microSecond = this->dataReader->getTimeStamp();
+	order.amount = amount;
+	order.orderId = order_id;
+	order.price = price;
+	order.side = side;
+	order.state = OrderState::AMEND;
+	this->addToBuffer(order);
+}
 
-std::vector<Order> SimExchange::getFills() {
-	std::vector<Order> retval(this->executions);
-	this->executions.clear();
-	return retval;
+void SimExchange::cancel(OrderId order_id, OrderSide side) {
+	Order order{};
+	if (this->cancelRequest(order_id, side, order)) {
+		this->addToBuffer(order);
+	}
 }
 
-void SimExchange::cancel(std::map<std::string, Order>& quotes) {
-	for (auto &[fst, snd] : quotes) {
-		if(snd.state != OrderState::FILLED
-		   && snd.state != OrderState::CANCELLED
-		   && snd.state != OrderState::CANCELLED_ACK) {
-			snd.state = OrderState::CANCELLED;
-			snd.microSecond = this->dataReader.getTimeStamp();
-			this->addToBuffer(snd);
-		   }
+void SimExchange::submit(const std::vector<Order>& batch) {
+	const long long now = this->dataReader->getTimeStamp();
+	long long ack = -1;
+	long long cancel = -1;
+
+	for (const Order& request : batch) {
+		Order order = request;
+		if (request.state == OrderState::CANCELLED) {
+			if (!this->cancelRequest(request.orderId, request.side, order)) continue;
+			if (cancel < 0) cancel = this->cancel_latency.sample(this->latency_gen);
+			this->schedule(order, cancel);
+		} else {
+			if (ack < 0) ack = this->ack_latency.sample(this->latency_gen);
+			order.microSecond = now;
+			this->schedule(order, ack);
+		}
 	}
 }
 
-void SimExchange::processPending(const DataRow& obs) {
-	std::vector<long long> delete_stamps;
-	std::vector<Order> bids;
-	std::vector<Order> asks;
+bool SimExchange::cancelRequest(OrderId order_id, OrderSide side, Order& order) {
+	auto& quotes = side == OrderSide::BUY ? this->bid_quotes : this->ask_quotes;
+	Order* quote = quotes.find(order_id);
+	if (quote != nullptr && quote->state == OrderState::CANCELLED) return false;
+
+	order = Order{};
+	if (quote != nullptr) {
+		quote->state = OrderState::CANCELLED;
+		order = *quote;
+	} else {
+		// still on its way, the cancel is scheduled no earlier than the order so it follows it
+		order.orderId = order_id;
+		order.side = side;
+		order.state = OrderState::CANCELLED;
+	}
+	order.microSecond = this->dataReader->getTimeStamp();
+	return true;
+}
 
+bool SimExchange::isLive(OrderId order_id, OrderSide side) const {
+	const auto& quotes = side == OrderSide::BUY ? this->bid_quotes : this->ask_quotes;
+	if (const Order* quote = quotes.find(order_id)) {
+		return quote->state != OrderState::CANCELLED;
+	}
 
-	for (auto& [timestamp, orders] : timed_buffer) {
-		if (obs.id >= timestamp + delay) {
-			for (Order& order : orders) {
+	const auto& pending = side == OrderSide::BUY ? this->bid_pending : this->ask_pending;
+	const PendingTable::Entry* entry = pending.find(order_id);
+	return entry != nullptr && entry->news > 0;
+}
 
-				if (order.state == OrderState::NEW) {
-					if (order.side == OrderSide::BUY) {
-						if (order.price < obs.data.at("asks[0].price") || order.is_taker) {
-							order.state = OrderState::NEW_ACK;
-							bids.push_back(order);
-						}
-					}
-					else {
-						if (order.price > obs.data.at("bids[0].price") || order.is_taker) {
-							order.state = OrderState::NEW_ACK;
-							asks.push_back(order);
-						}
-					}
-				}
-				else if (order.state == OrderState::AMEND) {
-					if (order.side == OrderSide::BUY) {
-						auto& quotes = this->bid_quotes;
-					
-						if (quotes.find(order.orderId) != quotes.end()) {
-							quotes[order.orderId].state = OrderState::AMEND_ACK;
-							quotes[order.orderId] = order;
-						}
-					}
-					else {
-						auto& quotes = this->ask_quotes;
-						if (quotes.find(order.orderId) != quotes.end()) {
-							quotes[order.orderId].state = OrderState::AMEND_ACK;
-							quotes[order.orderId] = order;
-						}
-					}
-				}
-				else if (order.state == OrderState::CANCELLED) {
+void SimExchange::getFills(std::vector<Order>& fills) {
+	fills.clear();
+	fills.swap(this->executions);
+	this->level_fills.swap(this->reported_levels);
+	this->reported_levels.clear();
+}
 
-					if (order.side == OrderSide::BUY) {
-						auto it = this->bid_quotes.find(order.orderId);
+void SimExchange::cancel(OrderSlots& quotes) {
+	for (Order& order : quotes) {
+		if(order.state != OrderState::FILLED
+		   && order.state != OrderState::CANCELLED
+		   && order.state != OrderState::CANCELLED_ACK) {
+			order.state = OrderState::CANCELLED;
+			order.microSecond = this->dataReader->getTimeStamp();
+			this->addToBuffer(order);
+		   }
+	}
+}
 
-						if (it != this->bid_quotes.end()) {
-							it->second.state = OrderState::CANCELLED_ACK;
-							this->bid_quotes.erase(order.orderId);
-						}
-					}
-					else {
-						auto it = this->ask_quotes.find(order.orderId);
+void SimExchange::processPending() {
+	const long long timestamp_now = this->dataReader->getTimeStamp();
 
-						if (it != this->ask_quotes.end()) {
-							it->second.state = OrderState::CANCELLED_ACK;
-							this->ask_quotes.erase(order.orderId);
-						}
-					}
+	timed_buffer.release(timestamp_now, [this](Order& order) {
+		auto& quotes = order.side == OrderSide::BUY ? this->bid_quotes : this->ask_quotes;
+		auto& printed = order.side == OrderSide::BUY ? this->bid_printed : this->ask_printed;
+		auto& filled = order.side == OrderSide::BUY ? this->bid_filled : this->ask_filled;
+		if (order.state != OrderState::FILLED) {
+			(order.side == OrderSide::BUY ? this->bid_pending : this->ask_pending).remove(order);
+		}
+
+		if (order.state == OrderState::NEW) {
+			bool accepted = order.side == OrderSide::BUY
+			                ? order.price < this->dataReader->getBestAskPrice()
+			                : order.price > this->dataReader->getBestBidPrice();
+			if (accepted || order.is_taker) {
+				order.state = OrderState::NEW_ACK;
+				Order& quote = quotes.insert(order);
+				printed[quotes.slotOf(quote)] = 0;
+				filled[quotes.slotOf(quote)] = 0;
+				if (this->queue_fills) this->queue.join(quote, quotes.slotOf(quote), this->replay_book);
+			}
+		}
+		else if (order.state == OrderState::AMEND) {
+			// an amend that would cross is rejected like a post only order and the quote stays as it was,
+			// an accepted one sizes the order anew, so what it filled already counts against the new size
+			Order* quote = quotes.find(order.orderId);
+			bool accepted = order.side == OrderSide::BUY
+			                ? order.price < this->dataReader->getBestAskPrice()
+			                : order.price > this->dataReader->getBestBidPrice();
+			if (quote != nullptr && accepted && quote->state != OrderState::CANCELLED) {
+				size_t slot = quotes.slotOf(*quote);
+				double amount = order.amount - filled[slot];
+				if (amount <= 0.00001) {
+					quotes.erase(*quote);
+					return;
 				}
-				else {
-					assert(order.state == OrderState::FILLED);
-					executions.push_back(order);
+
+				// a new price goes to the back of that level, a smaller amount keeps its place
+				bool requeue = std::abs(quote->price - order.price) > 0.00001 || amount > quote->amount;
+				quote->price = order.price;
+				quote->amount = amount;
+				quote->state = OrderState::AMEND_ACK;
+				if (requeue) {
+					printed[slot] = 0;
+					if (this->queue_fills) this->queue.join(*quote, slot, this->replay_book);
 				}
 			}
-
-			delete_stamps.push_back(timestamp);
 		}
-	}
-
-	for (auto timestamp : delete_stamps)
-		timed_buffer.erase(timestamp);
-
-	for (const auto& order : bids) {
-		this->bid_quotes[order.orderId] = order;
-	}
+		else if (order.state == OrderState::CANCELLED) {
+			quotes.erase(order.orderId);
+		}
+		else {
+			assert(order.state == OrderState::FILLED);
+			if (order.is_taker) this->reportLevels(order);
+			executions.push_back(order);
+		}
+	});
+}
 
-	for(const auto& order: asks) {
-		this->ask_quotes[order.orderId] = order;
+void SimExchange::reportLevels(const Order& fill) {
+	// the levels keep their walking order, the ones of other fills close up in place
+	size_t kept = 0;
+	for (const LevelFill& level : this->walked_levels) {
+		if (level.orderId == fill.orderId && level.side == fill.side) this->reported_levels.push_back(level);
+		else this->walked_levels[kept++] = level;
 	}
+	this->walked_levels.resize(kept);
 }
 
 void SimExchange::cancelOrders() {
@@ -234,45 +467,143 @@ void SimExchange::cancelOrders() {
 }
 
 void SimExchange::addToBuffer(const Order& order) {
-	if (this->timed_buffer.find(order.microSecond) == this->timed_buffer.end()) {
-		this->timed_buffer[order.microSecond] = std::vector<Order>();
+	LatencyModel& latency = order.state == OrderState::CANCELLED ? this->cancel_latency
+	                        : order.state == OrderState::FILLED ? this->fill_latency
+	                        : this->ack_latency;
+	this->schedule(order, latency.sample(this->latency_gen));
+}
+
+void SimExchange::schedule(const Order& order, long long latency) {
+	long long due = order.microSecond + latency;
+
+	// requests for one order reach the venue in the order they were sent,
+	// so a cancel or amend drawing a shorter latency waits for the order it is for
+	if (order.state == OrderState::FILLED) {
+		// fills are reported from the next row on, as they were before fill latencies
+		due = std::max(due, this->dataReader->getTimeStamp() + 1);
+	} else {
+		auto& pending = order.side == OrderSide::BUY ? this->bid_pending : this->ask_pending;
+		if (const PendingTable::Entry* entry = pending.find(order.orderId)) {
+			due = std::max(due, entry->due);
+		}
+		pending.add(order, due);
 	}
 
-	this->timed_buffer[order.microSecond].push_back(order);
+	this->timed_buffer.schedule(due, order);
 }
 
 void SimExchange::execute() {
-	const DataRow& obs = this->dataReader.current();
-	this->processPending(obs);
+	// prints since the previous row hit the quotes that were resting then, before new ones are acked
+	if (this->trades) {
+		this->fillFromTrades();
+	}
 
-	std::vector<std::string> bids_filled;
-	std::vector<std::string> asks_filled;
+	this->processPending();
+
+	const long long timestamp_now = this->dataReader->getTimeStamp();
+
+	for (Order& order : this->bid_quotes) {
+		if (order.is_taker) {
+			double vwap = 0;
+			double filled = this->walkBook(order, vwap);
+			if (filled > 0) order.price = vwap;
+			this->fillQuote(this->bid_quotes, order, filled, timestamp_now);
+		} else if (!this->trades && order.price > 0.00001 + this->dataReader->getBestBidPrice()) {
+			this->fillQuote(this->bid_quotes, order, order.amount, timestamp_now);
+		} else if (this->queue_fills) {
+			double fill = this->queue.onBook(order, this->bid_quotes.slotOf(order), this->replay_book, this->trades != nullptr);
+			this->fillQuote(this->bid_quotes, order, fill, timestamp_now);
+		}
+	}
 
-	for (auto& [order_id, order] : this->bid_quotes) {
-		if (order.side == OrderSide::BUY && order.price > 0.00001 + this->dataReader.getDouble("bids[0].price") || order.is_taker) {
-			order.state = OrderState::FILLED;
-			if (order.is_taker) order.price = this->dataReader.getDouble("asks[0].price");
-			bids_filled.push_back(order_id);
-			this->addToBuffer(order);
+	for (Order& order : this->ask_quotes) {
+		if (order.is_taker) {
+			double vwap = 0;
+			double filled = this->walkBook(order, vwap);
+			if (filled > 0) order.price = vwap;
+			this->fillQuote(this->ask_quotes, order, filled, timestamp_now);
+		} else if (!this->trades && order.price + 0.00001 < this->dataReader->getBestAskPrice()) {
+			this->fillQuote(this->ask_quotes, order, order.amount, timestamp_now);
+		} else if (this->queue_fills) {
+			double fill = this->queue.onBook(order, this->ask_quotes.slotOf(order), this->replay_book, this->trades != nullptr);
+			this->fillQuote(this->ask_quotes, order, fill, timestamp_now);
 		}
 	}
+}
 
+double SimExchange::walkBook(const Order& order, double& vwap) {
+	const auto& prices = order.side == OrderSide::BUY ? this->replay_book.ask_prices : this->replay_book.bid_prices;
+	const auto& sizes = order.side == OrderSide::BUY ? this->replay_book.ask_sizes : this->replay_book.bid_sizes;
+
+	double remaining = order.amount;
+	double notional = 0;
+	for (size_t ii = 0; ii < OrderBook::MAX_LEVELS && prices[ii] > 0 && remaining > 0.00001; ++ii) {
+		// whatever the visible book cannot take fills at its deepest level
+		double take = ii + 1 < OrderBook::MAX_LEVELS && prices[ii + 1] > 0 ? std::min(remaining, sizes[ii]) : remaining;
+		if (take <= 0) continue;
+		this->walked_levels.push_back(LevelFill{order.orderId, order.side, prices[ii], take});
+		notional += take * prices[ii];
+		remaining -= take;
+	}
 
-	for(auto& [order_id, order] : this->ask_quotes) {
-		if (order.side == OrderSide::SELL && order.price + 0.00001 < this->dataReader.getDouble("asks[0].price") || order.is_taker) {
-			order.state = OrderState::FILLED;
-			if (order.is_taker) order.price = this->dataReader.getDouble("bids[0].price");
-			asks_filled.push_back(order_id);
-			this->addToBuffer(order);
+	// an empty opposite side fills nothing, the order waits for a row with a book to take from
+	double filled = order.amount - remaining;
+	if (filled > 0) vwap = notional / filled;
+	return filled;
+}
+
+void SimExchange::fillFromTrades() {
+	const long long timestamp_now = this->dataReader->getTimeStamp();
+
+	for (; next_trade < trades->size() && trades->timestamp(next_trade) <= timestamp_now; ++next_trade) {
+		const double price = trades->price(next_trade);
+		const double amount = trades->amount(next_trade);
+		const bool sell = trades->side(next_trade) == OrderSide::SELL;
+
+		// a sell print trades against the bids, a buy print against the asks
+		auto& quotes = sell ? this->bid_quotes : this->ask_quotes;
+		auto& printed = sell ? this->bid_printed : this->ask_printed;
+		for (Order& order : quotes) {
+			double fill = 0;
+
+			if (!order.is_taker) {
+				if (sell ? price + 0.00001 < order.price : price > order.price + 0.00001) {
+					fill = order.amount;
+				} else if (std::abs(price - order.price) <= 0.00001) {
+					if (this->queue_fills) {
+						// the print works through the size queued ahead first
+						fill = this->queue.onPrint(order, quotes.slotOf(order), amount);
+					} else {
+						auto& volume = printed[quotes.slotOf(order)];
+						volume += amount;
+						fill = volume + 0.00001 >= order.amount ? order.amount : 0;
+					}
+				}
+			}
+
+			this->fillQuote(quotes, order, fill, trades->timestamp(next_trade));
 		}
 	}
+}
 
+void SimExchange::fillQuote(OrderSlots& quotes, Order& order, double amount, long long timestamp) {
+	if (amount <= 0.00001) return;
 
-	for (auto& order_id : bids_filled) {
-		this->bid_quotes.erase(order_id);
+	if (amount + 0.00001 >= order.amount) {
+		order.state = OrderState::FILLED;
+		order.microSecond = timestamp;
+		this->addToBuffer(order);
+		quotes.erase(order);
+		return;
 	}
 
-	for (auto& order_id : asks_filled) {
-		this->ask_quotes.erase(order_id);
-	}
+	// a partial fill is reported for its own amount and the rest keeps resting
+	auto& filled = order.side == OrderSide::BUY ? this->bid_filled : this->ask_filled;
+	filled[quotes.slotOf(order)] += amount;
+	Order fill = order;
+	fill.state = OrderState::FILLED;
+	fill.amount = amount;
+	fill.microSecond = timestamp;
+	this->addToBuffer(fill);
+	order.amount -= amount;
 }
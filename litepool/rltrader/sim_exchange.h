@@ -1,78 +1,218 @@
 #pragma once
 #include <string>
-#include <map>
+#include <array>
 #include <vector>
 #include <cstdint>
+#include <memory>
+#include <random>
+#include <type_traits>
 
 #include "base_exchange.h"
 #include "order.h"
-#include "csv_reader.h"
+#include "order_slots.h"
+#include "latency_model.h"
+#include "timing_wheel.h"
+#include "pending_table.h"
+#include "base_reader.h"
+#include "feature_store.h"
+#include "trade_tape.h"
+#include "queue_engine.h"
 #include "orderbook.h"
 
 namespace RLTrader {
     class SimExchange final : public BaseExchange {
     public:
-        // initialized labels
-        static bool initialize();
+        static constexpr size_t MAX_PENDING = 256;     // orders in flight a snapshot can hold
+        static constexpr size_t MAX_EXECUTIONS = 256;  // unreported fills a snapshot can hold
+        static constexpr size_t MAX_LEVEL_FILLS = 256; // levels of unreported taker fills a snapshot can hold
+
+        // Flat copy of the replay position and the matching state, restored into the same episode file
+        struct Snapshot {
+            size_t file_hash;    // std::hash of the episode's file name
+            size_t episode_row;  // row the episode started on
+            size_t row;
+            size_t rows_read;
+            size_t next_trade;
+            OrderSlots bid_quotes;
+            OrderSlots ask_quotes;
+            std::array<double, OrderSlots::CAPACITY> bid_printed;
+            std::array<double, OrderSlots::CAPACITY> ask_printed;
+            std::array<double, OrderSlots::CAPACITY> bid_filled;
+            std::array<double, OrderSlots::CAPACITY> ask_filled;
+            QueueEngine queue;
+            std::mt19937 latency_gen;
+            long long released_bucket;
+            size_t num_pending;
+            std::array<long long, MAX_PENDING> pending_due;
+            std::array<Order, MAX_PENDING> pending;
+            size_t num_executions;
+            std::array<Order, MAX_EXECUTIONS> executions;
+            size_t num_walked;    // levels of taker fills in flight, followed by
+            size_t num_reported;  // the levels of those in executions
+            std::array<LevelFill, MAX_LEVEL_FILLS> levels;
+        };
 
         // Constructor
-        SimExchange(const std::string& filename, long delay, int start_read, int max_read); // 300 milliseconds delay
-
-        // Generates an OrderBook
-        void toBook(const std::unordered_map<std::string, double>& lob, OrderBook& book) override;
+        // shared_data replays from the process-wide DatasetCache instead of a private reader,
+        // prefetch_depth > 0 parses csv batches ahead on a background thread,
+        // precompute_features serves market signals from the file's feature store once an episode has read
+        // more than MarketSignalBuilder::HISTORY_ROWS rows,
+        // trade_fills fills resting quotes from the printed volume of the file's .trades tape,
+        // queue_fills partially fills quotes once the size queued ahead of them at their level is gone
+        SimExchange(const std::string& filename, long delay, int start_read, int max_read,
+                    bool shared_data = false, int prefetch_depth = 0,
+                    bool precompute_features = false, bool trade_fills = false,
+                    bool queue_fills = false); // delay is a constant order and cancel latency, fills report on the next row
 
         // Resets the exchange's state
         void reset() override;
 
+        // Samples the order/amend ack, cancel and fill report legs from these models from now on
+        void setLatency(const LatencyModel& ack, const LatencyModel& cancel, const LatencyModel& fill, unsigned seed);
+
+        // Makes the next reset replay filename from start_row, reopening the reader only if the file changes
+        void setEpisode(const std::string& filename, size_t start_row);
+
+        // Makes the next reset seed the latency generator with seed, otherwise each reset draws its seed from it
+        void setEpisodeSeed(unsigned seed);
+
+        bool getEpisode(EpisodeStart& episode) const override;
+
         // Advances to the next row in the data
-        bool next_read(size_t& slot, OrderBook& book) override;
+        // Hands out the replayed book, patched in place with the columns the row changed
+        const OrderBook* next_book(size_t& slot) override;
 
         void done_read(size_t slot) override;
 
+        [[nodiscard]] long long getTimeStamp() const override { return dataReader->getTimeStamp(); }
+
         // fetch dummy zero positions
         void fetchPosition(double& posAmount, double& avgPrice) override;
 
 
-        // Returns executed orders and clears them
-        std::vector<Order> getFills() override;
+        // Swaps the executed orders into fills
+        void getFills(std::vector<Order>& fills) override;
 
         // Processes order cancellation
         void cancelOrders() override;
 
-         const std::map<std::string, Order>& getBidOrders() const override;
+         const OrderSlots& getBidOrders() const override;
 
-         const std::map<std::string, Order>& getAskOrders() const override;
+         const OrderSlots& getAskOrders() const override;
 
          std::vector<Order> getUnackedOrders() const override;
 
-         void quote(std::string order_id, OrderSide side, const double& price, const double& amount) override;
+         void quote(OrderId order_id, OrderSide side, const double& price, const double& amount) override;
+
+         void market(OrderId order_id, OrderSide side, const double& price, const double& amount) override;
+
+         void amend(OrderId order_id, OrderSide side, const double& price, const double& amount) override;
+
+         void cancel(OrderId order_id, OrderSide side) override;
+
+         // The batch arrives as one message, every order in it comes due after the same latency draw
+         void submit(const std::vector<Order>& batch) override;
+
+         [[nodiscard]] bool isLive(OrderId order_id, OrderSide side) const override;
+
+         [[nodiscard]] const double* marketSignals() const override;
+
+         [[nodiscard]] bool isIdle() const override;
 
-         void market(std::string order_id, OrderSide side, const double& price, const double& amount) override;
+         // Looks the row up in the reader's index
+         size_t rowsUntil(long long timestamp) override;
+
+         // Skips the reader along in bulk without touching the matching path, builds only the books of the last
+         // history rows and moves the trade cursor once at the end
+         size_t advance(size_t rows, size_t history, std::vector<OrderBook>& books) override;
+
+         // Copies the exchange's state, throws if more orders are in flight than a snapshot holds
+         void snapshot(Snapshot& snap) const;
+
+         // Goes back to a snapshot of this episode, the reader seeks to the row, which reopens a csv file.
+         // Throws if the snapshot was taken in another episode.
+         void restore(const Snapshot& snap);
+
+         // Levels the taker fills handed out by the last getFills walked through, the fills carry the VWAP
+         [[nodiscard]] const std::vector<LevelFill>& getLevelFills() const { return level_fills; }
 
     private:
-        CsvReader dataReader; // reader
-        long delay;           // Delay to process timed buffer  
-        std::map<std::string, Order> bid_quotes;  // Active buy orders
-        std::map<std::string, Order> ask_quotes;  // Active sell orders
+        std::unique_ptr<BaseReader> dataReader; // reader
+        std::string filename;  // file dataReader replays
+        int start_read;
+        int max_read;
+        size_t rows_read = 0;  // rows advanced since the episode started, capped at max_read
+        bool shared_data;
+        int prefetch_depth;
+        bool precompute_features;
+        std::shared_ptr<const FeatureStore> features;  // market signals per row of filename, if precomputed
+        bool trade_fills;
+        std::shared_ptr<const TradeTape> trades;  // prints of filename, if fills are trade driven
+        size_t next_trade = 0;  // first print not yet matched against the quotes
+        std::array<double, OrderSlots::CAPACITY> bid_printed{};  // volume printed at a resting bid's price, by slot
+        std::array<double, OrderSlots::CAPACITY> ask_printed{};  // same for the asks
+        std::array<double, OrderSlots::CAPACITY> bid_filled{};   // amount a resting bid has filled so far, by slot
+        std::array<double, OrderSlots::CAPACITY> ask_filled{};   // same for the asks
+        bool queue_fills;
+        QueueEngine queue;  // size ahead of each resting quote, used with queue_fills
+        std::string episode_file;  // episode set for the next reset, empty for a random start
+        size_t episode_start = 0;
+        bool seed_pinned = false;  // whether the next reset uses pinned_seed
+        unsigned pinned_seed = 0;
+        size_t episode_row = 0;     // row the current episode started on
+        unsigned episode_seed = 0;  // latency seed the current episode started with
+        OrderBook replay_book;  // book of the current row, patched in place as rows advance
+        LatencyModel ack_latency;     // until a new or amended order is acked
+        LatencyModel cancel_latency;  // until a cancel is acked
+        LatencyModel fill_latency;    // until a fill is reported, 0 reports it on the next row as before latency models
+        std::mt19937 latency_gen;
+        OrderSlots bid_quotes;  // Active buy orders
+        OrderSlots ask_quotes;  // Active sell orders
         std::vector<Order> executions;       // Executed orders
-        std::map<long long, std::vector<Order>> timed_buffer;  // Orders waiting for processing
+        std::vector<LevelFill> walked_levels;    // levels of taker fills not reported yet
+        std::vector<LevelFill> reported_levels;  // levels of the taker fills in executions
+        std::vector<LevelFill> level_fills;      // levels of the fills the last getFills handed out
+        TimingWheel<Order> timed_buffer;  // Orders waiting for processing, keyed on when they come due
+        PendingTable bid_pending;  // requests for buy orders in timed_buffer, by order id
+        PendingTable ask_pending;  // same for sell orders
+
+        static_assert(std::is_trivially_copyable_v<Snapshot>, "Snapshots are copied as flat blobs");
 
         // cancel orders for a side
-        void cancel(std::map<std::string, Order>& quotes);
+        void cancel(OrderSlots& quotes);
 
         // Executes orders based on current market conditions
         void execute();
 
-        // Adds orders to the buffer
+        // Fills resting quotes from the prints up to the current row
+        void fillFromTrades();
+
+        // Fills amount of a resting quote at timestamp, removing it once nothing is left
+        void fillQuote(OrderSlots& quotes, Order& order, double amount, long long timestamp);
+
+        // Moves the trade cursor past the current row
+        void rewindTrades();
+
+        // Fills a taker order against the levels of the current book, returns the amount filled and sets vwap
+        double walkBook(const Order& order, double& vwap);
+
+        // Marks a resting quote cancelled and fills in the cancel to buffer, false if it is cancelled already
+        bool cancelRequest(OrderId order_id, OrderSide side, Order& order);
+
+        // Adds orders to the buffer, due after a latency drawn for their leg
         void addToBuffer(const Order& order);
 
+        // Adds an order due latency after it was sent, and no earlier than the requests pending for its id
+        void schedule(const Order& order, long long latency);
+
+        // Moves the walked levels of a taker fill to the reported ones as the fill is reported
+        void reportLevels(const Order& fill);
+
         // Processes orders that are pending based on their timestamps
-        void processPending(const DataRow& obs);
+        void processPending();
 
-        static std::vector<std::string> ask_price_labels;
-        static std::vector<std::string> bid_price_labels;
-        static std::vector<std::string> ask_size_labels;
-        static std::vector<std::string> bid_size_labels;
-        static bool init;
+        // Opens a shared reader, a tick (.bin), block (.blk) or delta (.dlt) reader, or a csv reader (anything else)
+        static std::unique_ptr<BaseReader> makeReader(const std::string& filename, int start_read, int max_read,
+                                                      bool shared_data, int prefetch_depth);
     };
 }
@@ -2,6 +2,8 @@
 #include <string>
 #include <cmath>
 #include <cassert>
+#include <sstream>
+#include <stdexcept>
 #include "orderbook.h"
 #include "position_signal_builder.h"
 #include <iostream>
@@ -25,6 +27,48 @@ void Strategy::reset() {
         //std::cout << "initial price=" << avgPrice << std::endl;
 	this->position.reset(initQty, avgPrice);
 	this->order_id = 0;
+	this->bid_quotes.fill(WorkingQuote{});
+	this->ask_quotes.fill(WorkingQuote{});
+}
+
+void Strategy::setGrid(size_t levels, const std::vector<double>& profile) {
+	if (levels == 0 || levels > MAX_GRID_LEVELS) {
+		throw std::runtime_error("Grid levels must be between 1 and " + std::to_string(MAX_GRID_LEVELS));
+	}
+
+	if (!profile.empty() && profile.size() != levels) {
+		throw std::runtime_error("Grid profile needs one weight per level");
+	}
+
+	double total = 0;
+	for (double weight : profile) {
+		if (weight < 0) throw std::runtime_error("Grid profile weights must not be negative");
+		total += weight;
+	}
+
+	if (!profile.empty() && total <= 0) {
+		throw std::runtime_error("Grid profile needs a positive weight");
+	}
+
+	this->grid_levels = levels;
+	this->grid_weights.fill(0);
+	for (size_t ii = 0; ii < levels; ++ii) {
+		this->grid_weights[ii] = profile.empty() ? 1.0 / static_cast<double>(levels) : profile[ii] / total;
+	}
+}
+
+std::vector<double> Strategy::parseProfile(const std::string& profile) {
+	std::vector<double> weights;
+	std::stringstream ss(profile);
+	std::string weight;
+	try {
+		while (std::getline(ss, weight, ',')) {
+			weights.push_back(std::stod(weight));
+		}
+	} catch (const std::logic_error&) {
+		throw std::runtime_error("Invalid grid profile " + profile);
+	}
+	return weights;
 }
 
 void Strategy::quote(int buy_spread, int sell_spread, int buy_percent, int sell_percent,
@@ -40,28 +84,93 @@ void Strategy::quote(int buy_spread, int sell_spread, int buy_percent, int sell_
         int skew = static_cast<int>(leverage);
         buy_spread = std::max(0, buy_spread + skew);
         sell_spread = std::max(0, sell_spread - skew);
-        
-        this->exchange.cancelOrders();
 
-        if (buy_volume > 0 && buy_spread >= 0 && buy_spread < 20)
-        	this->sendGrid(1, buy_spread, buy_volume, OrderSide::BUY, bid_prices);
-        if (sell_volume > 0 && sell_spread >= 0 && sell_spread < 20)
-        	this->sendGrid(1, sell_spread, sell_volume, OrderSide::SELL, ask_prices);
-}
+        bool buy_wanted = buy_volume > 0 && buy_spread >= 0 && buy_spread < 20;
+        bool sell_wanted = sell_volume > 0 && sell_spread >= 0 && sell_spread < 20;
+        this->batch.clear();
+
+        // levels past the grid, or past the book, cancel what they still have working
+        for (size_t level = 0; level < MAX_GRID_LEVELS; ++level) {
+                size_t buy_level = buy_spread + level;
+                size_t sell_level = sell_spread + level;
+                bool buy_level_wanted = buy_wanted && level < grid_levels && buy_level < 20 && bid_prices[buy_level] > 0;
+                bool sell_level_wanted = sell_wanted && level < grid_levels && sell_level < 20 && ask_prices[sell_level] > 0;
+                auto buy_amount = buy_level_wanted
+                                  ? instrument.getTradeAmount(buy_volume * grid_weights[level], bid_prices[0]) : 0.0;
+                auto sell_amount = sell_level_wanted
+                                   ? instrument.getTradeAmount(sell_volume * grid_weights[level], ask_prices[0]) : 0.0;
+
+                this->requote(this->bid_quotes[level], OrderSide::BUY,
+                              buy_level_wanted && buy_amount >= instrument.getMinAmount(),
+                              buy_level_wanted ? bid_prices[buy_level] : 0.0, buy_amount);
+                this->requote(this->ask_quotes[level], OrderSide::SELL,
+                              sell_level_wanted && sell_amount >= instrument.getMinAmount(),
+                              sell_level_wanted ? ask_prices[sell_level] : 0.0, sell_amount);
+        }
 
-void Strategy::sendGrid(int levels, int start_level, const double& amount,
-	                    OrderSide side, FixedVector<double, 20>& refPrices) {
-        for (int ii = 0; ii < levels; ++ii) {
-	     auto trade_amount = instrument.getTradeAmount(amount, refPrices[0]);
-             if (trade_amount >= instrument.getMinAmount()) {
-             	this->exchange.quote(std::to_string(++order_id), side, refPrices[ii + start_level], trade_amount);
-             }
+        if (!this->batch.empty()) {
+                this->exchange.submit(this->batch);
         }
 }
 
-void Strategy::next() {
-    auto fills = exchange.getFills();
-    for(const auto& order: fills) {
+void Strategy::request(OrderState state, OrderId id, OrderSide side, const double& price, const double& amount) {
+	Order order{};
+	order.is_taker = false;
+	order.orderId = id;
+	order.side = side;
+	order.price = price;
+	order.amount = amount;
+	order.state = state;
+	this->batch.push_back(order);
+}
+
+void Strategy::requote(WorkingQuote& working, OrderSide side, bool wanted, const double& price, const double& amount) {
+	// filled, cancelled or rejected quotes are replaced by a new one
+	if (working.id != 0 && !this->exchange.isLive(working.id, side)) {
+		working = WorkingQuote{};
+	}
+
+	if (!wanted) {
+		if (working.id != 0) {
+			this->request(OrderState::CANCELLED, working.id, side, 0, 0);
+			working = WorkingQuote{};
+		}
+		return;
+	}
+
+	if (working.id == 0) {
+		working = WorkingQuote{++order_id, price, amount};
+		this->request(OrderState::NEW, working.id, side, price, amount);
+		return;
+	}
+
+	if (std::abs(working.price - price) < 0.00001 && std::abs(working.amount - amount) < 0.00001) {
+		return;
+	}
+
+	working.price = price;
+	working.amount = amount;
+	this->request(OrderState::AMEND, working.id, side, price, amount);
+}
+
+void Strategy::snapshot(Snapshot& snap) const {
+	this->position.snapshot(snap.position);
+	snap.order_id = this->order_id;
+	snap.bid_quotes = this->bid_quotes;
+	snap.ask_quotes = this->ask_quotes;
+}
+
+void Strategy::restore(const Snapshot& snap) {
+	this->position.restore(snap.position);
+	this->order_id = snap.order_id;
+	this->bid_quotes = snap.bid_quotes;
+	this->ask_quotes = snap.ask_quotes;
+}
+
+size_t Strategy::next() {
+    exchange.getFills(this->fills);
+    for(const auto& order: this->fills) {
         position.onFill(order);
     }
+    return this->fills.size();
 }
@@ -1,6 +1,9 @@
 #pragma once
 
+#include <array>
 #include <memory>
+#include <string>
+#include <vector>
 
 #include "base_exchange.h"
 #include "orderbook.h"
@@ -9,6 +12,26 @@
 namespace RLTrader {
 	class Strategy {
 	public:
+		// The quote kept working on one side, id 0 when there is none
+		struct WorkingQuote {
+			OrderId id = 0;
+			double price = 0;
+			double amount = 0;
+		};
+
+		static constexpr size_t MAX_GRID_LEVELS = 8;
+
+		// Working quotes of a side's grid, nearest level first
+		using Ladder = std::array<WorkingQuote, MAX_GRID_LEVELS>;
+
+		// Flat copy of the strategy and its position
+		struct Snapshot {
+			Position::Snapshot position;
+			OrderId order_id;
+			Ladder bid_quotes;
+			Ladder ask_quotes;
+		};
+
 		Strategy(BaseInstrument& instr, BaseExchange& exch, const double& balance, int maxTicks);
 			
 		void reset();
@@ -18,15 +41,37 @@ namespace RLTrader {
 
 		Position& getPosition() { return position; }
 
-		void next();
+		// Quotes levels consecutive book levels per side from the spread level outwards, splitting a side's
+		// volume over them by profile, one weight per level; an empty profile splits it evenly
+		void setGrid(size_t levels, const std::vector<double>& profile = {});
+
+		// Parses a comma separated profile such as "3,2,1"
+		static std::vector<double> parseProfile(const std::string& profile);
+
+		// Applies the fills since the last call to the position and returns how many there were
+		size_t next();
+
+		void snapshot(Snapshot& snap) const;
+
+		void restore(const Snapshot& snap);
 
 	private:
 		BaseInstrument& instrument;
 		BaseExchange& exchange;
 		Position position;
-		int order_id;
+		OrderId order_id;
 		int max_ticks;
-		void sendGrid(int levels, int start_level,
-			      const double& amount, OrderSide side, FixedVector<double, 20>& refPrices);
+		size_t grid_levels = 1;
+		std::array<double, MAX_GRID_LEVELS> grid_weights{1};
+		Ladder bid_quotes;
+		Ladder ask_quotes;
+		std::vector<Order> fills;  // swapped with the exchange's executions, so both buffers are reused
+		std::vector<Order> batch;  // requests of a quote() call, submitted together
+
+		// Keeps a side's grid level or batches the amend, new order or cancel that matches what is wanted
+		void requote(WorkingQuote& working, OrderSide side, bool wanted, const double& price, const double& amount);
+
+		// Batches a request for the exchange
+		void request(OrderState state, OrderId id, OrderSide side, const double& price, const double& amount);
 	};
 }
@@ -3,12 +3,37 @@
 #include <algorithm>
 
 #include <string>
+#include <sstream>
 #include <random>
 #include <chrono>
+#include <filesystem>
 #include "inverse_instrument.h"
 #include "csv_reader.h"
+#include "tick_file.h"
+#include "tick_converter.h"
+#include "tick_reader.h"
+#include "block_reader.h"
+#include "delta_reader.h"
+#include "merged_reader.h"
+#include "episode_sampler.h"
+#include "dataset_cache.h"
+#include "line_index.h"
+#include "feature_store.h"
+#include <cmath>
+#include <fstream>
+#include <set>
 #include "position.h"
 #include "sim_exchange.h"
+#include "order_slots.h"
+#include "ring_queue.h"
+#include "timing_wheel.h"
+#include "pending_table.h"
+#include "latency_model.h"
+#include "queue_engine.h"
+#include "journal.h"
+#include "journal_exchange.h"
+#include "deribit_orders.h"
+#include "trade_tape.h"
 #include "strategy.h"
 #include "orderbook.h"
 #include "market_signal_builder.h"
@@ -171,6 +196,65 @@ TEST_CASE("env adaptor test") {
 	CHECK(std::all_of(signals.begin(), signals.end(), [](double val) {return std::isfinite(val);}));
 	CHECK(std::all_of(signals.begin(), signals.end(), [](double val) { return std::abs(val) < 10;}));
 	CHECK(std::all_of(signals.begin(), signals.end(), [](double val) { return std::abs(val) >= 0;}));
+
+	// the default config observes the live market signals followed by the position and trade ones
+	MarketSignalBuilder builder;
+	SimExchange replay("data.csv", 5, 0, 100);
+	adaptor.reset();
+	replay.reset();
+	OrderBook book;
+	size_t slot;
+	for (int ii = 0; ii < 10; ++ii) {
+		REQUIRE(adaptor.next());
+		std::vector<double> expected;
+		// a step reads two rows and builds signals on both
+		for (int row = 0; row < 2; ++row) {
+			REQUIRE(replay.next_read(slot, book));
+			expected = builder.add_book(book);
+		}
+		adaptor.getState(signals);
+		for (size_t jj = 0; jj < MarketSignalBuilder::NUM_SIGNALS; ++jj) {
+			CHECK(signals[jj] == Approx(expected[jj]));
+		}
+	}
+	CHECK(std::any_of(signals.begin(), signals.begin() + MarketSignalBuilder::NUM_SIGNALS,
+	                  [](double value) { return value != 0; }));
+}
+
+TEST_CASE("test of lagged signals from any start row") {
+	// the lagged OFI signals look back from the latest book, so two builders started on different rows agree
+	// once the later one has seen HISTORY_ROWS books, whichever slot of its ring the first book landed on
+	CsvReader reader("data.csv", 0, 1000);
+	std::vector<OrderBook> books;
+	reader.seek(0);
+	while (true) {
+		OrderBook book;
+		reader.toBook(book);
+		books.push_back(book);
+		if (!reader.hasNext()) break;
+		reader.advance();
+	}
+
+	const size_t start = MarketSignalBuilder::HISTORY_ROWS + 17;
+	REQUIRE(books.size() > start + 3 * MarketSignalBuilder::HISTORY_ROWS);
+	MarketSignalBuilder from_top;
+	MarketSignalBuilder from_start;
+	size_t compared = 0;
+	for (size_t row = 0; row < books.size(); ++row) {
+		auto expected = from_top.add_book(books[row]);
+		if (row < start) continue;
+		auto signals = from_start.add_book(books[row]);
+		if (row - start < MarketSignalBuilder::HISTORY_ROWS) continue;
+		for (size_t ii = 0; ii < MarketSignalBuilder::NUM_SIGNALS; ++ii) {
+			if (std::isnan(expected[ii])) {
+				CHECK(std::isnan(signals[ii]));
+			} else {
+				CHECK(signals[ii] == Approx(expected[ii]));
+			}
+		}
+		++compared;
+	}
+	CHECK(compared > 0);
 }
 
 TEST_CASE("test of OrderBook and signals") {
@@ -255,6 +339,9 @@ TEST_CASE("testing the csv reader") {
 		_ = next.getBestBidPrice();
 		counter++;
 	}
+	CHECK(reader.current().bidPrice(1) == Approx(reader.getDouble("bids[1].price")));
+	CHECK(reader.current().askAmount(4) == Approx(reader.getDouble("asks[4].amount")));
+	CHECK_THROWS(reader.getDouble("local_timestamp"));
 
 	SimExchange exch("data.csv", 300, 0, 100);
 	exch.reset();
@@ -268,6 +355,728 @@ TEST_CASE("testing the csv reader") {
 		++counter;
 }
 
+TEST_CASE("testing the tick file reader") {
+	const size_t levels = 5;
+	std::vector<long long> timestamps;
+	std::vector<std::vector<double>> columns(levels * NUM_FIELDS);
+	CsvReader reader("data.csv", 0, 100000);
+	reader.reset();
+	while (true) {
+		const auto& row = reader.current();
+		timestamps.push_back(row.id);
+		for (size_t level = 0; level < levels; ++level) {
+			columns[level * NUM_FIELDS + ASK_PRICE].push_back(row.askPrice(level));
+			columns[level * NUM_FIELDS + ASK_AMOUNT].push_back(row.askAmount(level));
+			columns[level * NUM_FIELDS + BID_PRICE].push_back(row.bidPrice(level));
+			columns[level * NUM_FIELDS + BID_AMOUNT].push_back(row.bidAmount(level));
+		}
+		if (!reader.hasNext()) break;
+		reader.next();
+	}
+
+	auto binfile = (std::filesystem::temp_directory_path() / "litepool_data_test.bin").string();
+	TickFile::write(binfile, levels, timestamps, columns);
+
+	TickFile file(binfile);
+	CHECK(file.rows() == timestamps.size());
+	CHECK(file.levels() == levels);
+	CHECK(file.timestamps()[0] == 1714348800182912);
+	CHECK(file.column(0, ASK_AMOUNT)[1] == Approx(530));
+
+	SimExchange csv_exch("data.csv", 5, 0, 100);
+	SimExchange bin_exch(binfile, 5, 0, 100);
+	OrderBook csv_book;
+	OrderBook bin_book;
+	size_t slot;
+	int counter = 0;
+	while (csv_exch.next_read(slot, csv_book)) {
+		CHECK(bin_exch.next_read(slot, bin_book));
+		for (size_t level = 0; level < levels; ++level) {
+			CHECK(bin_book.bid_prices[level] == csv_book.bid_prices[level]);
+			CHECK(bin_book.ask_prices[level] == csv_book.ask_prices[level]);
+			CHECK(bin_book.bid_sizes[level] == csv_book.bid_sizes[level]);
+			CHECK(bin_book.ask_sizes[level] == csv_book.ask_sizes[level]);
+		}
+		++counter;
+	}
+	CHECK_FALSE(bin_exch.next_read(slot, bin_book));
+	CHECK(counter == 100);
+	std::filesystem::remove(binfile);
+}
+
+TEST_CASE("testing the block compressed reader") {
+	size_t levels = 0;
+	std::vector<long long> timestamps;
+	std::vector<std::vector<double>> columns;
+	TickConverter::readCsv("data.csv", levels, timestamps, columns);
+
+	auto blkfile = (std::filesystem::temp_directory_path() / "litepool_data_test.blk").string();
+	CHECK_THROWS_AS(BlockFile::write(blkfile, levels, timestamps, columns, 0), std::runtime_error);
+	BlockFile::write(blkfile, levels, timestamps, columns, 64);
+
+	BlockFile file(blkfile);
+	CHECK(file.rows() == timestamps.size());
+	CHECK(file.numBlocks() == (timestamps.size() + 63) / 64);
+	CHECK(file.blockIndex(1).first_timestamp == timestamps[64]);
+	CHECK(std::filesystem::file_size(blkfile) < timestamps.size() * (levels * NUM_FIELDS + 1) * sizeof(double));
+
+	DecodedBlock last;
+	file.decompress(file.numBlocks() - 1, last);
+	CHECK(last.first_row == (file.numBlocks() - 1) * 64);
+	CHECK(last.rows == timestamps.size() - last.first_row);
+	CHECK(last.timestamps.back() == timestamps.back());
+	CHECK(last.value(last.rows - 1, 2, BID_AMOUNT) == columns[2 * NUM_FIELDS + BID_AMOUNT].back());
+
+	for (int prefetch : {0, 2}) {
+		SimExchange csv_exch("data.csv", 5, 0, 300);
+		SimExchange blk_exch(blkfile, 5, 0, 300, false, prefetch);
+		OrderBook csv_book;
+		OrderBook blk_book;
+		size_t slot;
+		int counter = 0;
+		while (csv_exch.next_read(slot, csv_book)) {
+			CHECK(blk_exch.next_read(slot, blk_book));
+			for (size_t level = 0; level < levels; ++level) {
+				CHECK(blk_book.bid_prices[level] == csv_book.bid_prices[level]);
+				CHECK(blk_book.ask_sizes[level] == csv_book.ask_sizes[level]);
+			}
+			++counter;
+		}
+		CHECK_FALSE(blk_exch.next_read(slot, blk_book));
+		CHECK(counter == 300);
+	}
+
+	BlockReader reader(blkfile, 1500, 100, 1);
+	for (int ii = 0; ii < 5; ++ii) {
+		reader.reset();
+		int rows = 1;
+		while (reader.hasNext()) {
+			reader.advance();
+			++rows;
+		}
+		CHECK(rows <= 101);
+		CHECK(reader.getTimeStamp() >= timestamps.front());
+	}
+
+	auto shared = DatasetCache::get(blkfile);
+	CHECK(shared->rows() == timestamps.size());
+	CHECK(shared->column(4, ASK_PRICE)[100] == columns[4 * NUM_FIELDS + ASK_PRICE][100]);
+	shared.reset();
+	std::filesystem::remove(blkfile);
+}
+
+TEST_CASE("testing the delta encoded reader") {
+	size_t levels = 0;
+	std::vector<long long> timestamps;
+	std::vector<std::vector<double>> columns;
+	TickConverter::readCsv("data.csv", levels, timestamps, columns);
+
+	auto dltfile = (std::filesystem::temp_directory_path() / "litepool_data_test.dlt").string();
+	CHECK_THROWS_AS(DeltaFile::write(dltfile, levels, timestamps, columns, 0), std::runtime_error);
+	DeltaFile::write(dltfile, levels, timestamps, columns, 100);
+
+	DeltaFile file(dltfile);
+	CHECK(file.rows() == timestamps.size());
+	CHECK(file.snapshotInterval() == 100);
+	CHECK(std::filesystem::file_size(dltfile) < timestamps.size() * (levels * NUM_FIELDS + 1) * sizeof(double) / 4);
+
+	std::vector<long long> expanded_timestamps;
+	std::vector<std::vector<double>> expanded_columns;
+	file.expand(expanded_timestamps, expanded_columns);
+	CHECK(expanded_timestamps == timestamps);
+	CHECK(expanded_columns == columns);
+
+	SimExchange csv_exch("data.csv", 5, 0, 250);
+	SimExchange dlt_exch(dltfile, 5, 0, 250);
+	OrderBook csv_book;
+	OrderBook dlt_book;
+	size_t slot;
+	int counter = 0;
+	while (csv_exch.next_read(slot, csv_book)) {
+		CHECK(dlt_exch.next_read(slot, dlt_book));
+		for (size_t level = 0; level < levels; ++level) {
+			CHECK(dlt_book.bid_prices[level] == csv_book.bid_prices[level]);
+			CHECK(dlt_book.ask_prices[level] == csv_book.ask_prices[level]);
+			CHECK(dlt_book.bid_sizes[level] == csv_book.bid_sizes[level]);
+			CHECK(dlt_book.ask_sizes[level] == csv_book.ask_sizes[level]);
+		}
+		++counter;
+	}
+	CHECK_FALSE(dlt_exch.next_read(slot, dlt_book));
+	CHECK(counter == 250);
+
+	// random starts land between snapshots and must rebuild the full book
+	TickFile reference(levels, timestamps, columns);
+	DeltaReader reader(dltfile, 1800, 50);
+	for (int ii = 0; ii < 10; ++ii) {
+		reader.reset();
+		OrderBook book;
+		reader.toBook(book);
+		auto row = static_cast<size_t>(std::find(timestamps.begin(), timestamps.end(), reader.getTimeStamp()) - timestamps.begin());
+		REQUIRE(row < timestamps.size());
+		while (reader.hasNext()) {
+			reader.advance();
+			reader.patchBook(book);
+			++row;
+			CHECK(reader.getTimeStamp() == timestamps[row]);
+			for (size_t level = 0; level < levels; ++level) {
+				CHECK(book.bid_sizes[level] == reference.column(level, BID_AMOUNT)[row]);
+				CHECK(book.ask_prices[level] == reference.column(level, ASK_PRICE)[row]);
+			}
+		}
+	}
+	std::filesystem::remove(dltfile);
+}
+
+TEST_CASE("testing the episode sampler") {
+	auto folder = std::filesystem::temp_directory_path() / "litepool_catalog";
+	std::filesystem::remove_all(folder);
+	std::filesystem::create_directories(folder);
+	std::filesystem::copy_file("data.csv", folder / "a.csv");
+	{
+		std::ifstream in("data.csv");
+		std::ofstream out(folder / "b.csv");
+		std::string line;
+		for (int ii = 0; ii <= 200 && std::getline(in, line); ++ii) out << line << "\n";
+	}
+	// a file converted next to its csv is listed once, in the faster format
+	TickConverter::convert((folder / "a.csv").string(), (folder / "a.bin").string());
+
+	auto catalog = DatasetCatalog::get(folder.string());
+	CHECK(catalog == DatasetCatalog::get(folder.string()));
+	REQUIRE(catalog->entries().size() == 2);
+	CHECK(std::filesystem::path(catalog->entries()[0].filename).filename() == "a.bin");
+	CHECK(catalog->entries()[0].rows == 1997);
+	CHECK(catalog->entries()[1].rows == 200);
+	CHECK(catalog->totalRows() == 2197);
+
+	EpisodeSampler sampler(catalog, 150);
+	std::mt19937 gen(7);
+	std::mt19937 same_gen(7);
+	EpisodeSampler same_sampler(catalog, 150);
+	int short_file = 0;
+	for (int ii = 0; ii < 2000; ++ii) {
+		auto episode = sampler.sample(gen);
+		auto same = same_sampler.sample(same_gen);
+		CHECK(episode.filename == same.filename);
+		CHECK(episode.start_row == same.start_row);
+		bool is_short = episode.filename == catalog->entries()[1].filename;
+		CHECK(episode.start_row <= (is_short ? 49 : 1846));
+		if (is_short) ++short_file;
+	}
+	CHECK(short_file > 100);
+	CHECK(short_file < 280);
+
+	// a start setting caps the start rows like a reader's random start
+	EpisodeSampler capped(catalog, 150, 20);
+	for (int ii = 0; ii < 200; ++ii) {
+		CHECK(capped.sample(gen).start_row <= 20);
+	}
+
+	CsvReader reader(catalog->entries()[1].filename, 0, 10);
+	reader.seek(60);
+	reader.advance();
+	auto expected_next = reader.current().getBestBidPrice();
+
+	SimExchange exch(catalog->entries()[0].filename, 5, 0, 10);
+	exch.setEpisode(catalog->entries()[1].filename, 60);
+	exch.reset();
+	OrderBook book;
+	size_t slot;
+	CHECK(exch.next_read(slot, book));
+	CHECK(book.bid_prices[0] == expected_next);
+
+	auto converted = folder / "bin";
+	TickConverter::convertFolder(folder.string(), converted.string(), 2);
+	auto manifest_catalog = DatasetCatalog(converted.string());
+	REQUIRE(manifest_catalog.entries().size() == 2);
+	CHECK(manifest_catalog.entries()[1].filename == (std::filesystem::weakly_canonical(converted) / "b.bin").string());
+	CHECK(manifest_catalog.entries()[1].rows == 200);
+	CHECK(DatasetCatalog::countRows(manifest_catalog.entries()[1].filename) == 200);
+	std::filesystem::remove_all(folder);
+}
+
+TEST_CASE("testing episodes across files of different depths") {
+	size_t levels = 0;
+	std::vector<long long> timestamps;
+	std::vector<std::vector<double>> columns;
+	TickConverter::readCsv("data.csv", levels, timestamps, columns);
+	REQUIRE(levels == 5);
+
+	// a two level copy of the file in every format
+	const size_t shallow_levels = 2;
+	std::vector<std::vector<double>> shallow(columns.begin(), columns.begin() + shallow_levels * NUM_FIELDS);
+	auto folder = std::filesystem::temp_directory_path() / "litepool_depth_test";
+	std::filesystem::create_directories(folder);
+	auto csvfile = (folder / "shallow.csv").string();
+	{
+		std::ofstream out(csvfile);
+		out << "local_timestamp";
+		for (size_t level = 0; level < shallow_levels; ++level) {
+			out << ",asks[" << level << "].price,asks[" << level << "].amount,bids[" << level << "].price,bids["
+			    << level << "].amount";
+		}
+		out << "\n";
+		for (size_t row = 0; row < timestamps.size(); ++row) {
+			out << timestamps[row];
+			for (const auto& column : shallow) out << "," << column[row];
+			out << "\n";
+		}
+	}
+	auto binfile = (folder / "shallow.bin").string();
+	auto blkfile = (folder / "shallow.blk").string();
+	auto dltfile = (folder / "shallow.dlt").string();
+	TickFile::write(binfile, shallow_levels, timestamps, shallow);
+	BlockFile::write(blkfile, shallow_levels, timestamps, shallow, 16);
+	DeltaFile::write(dltfile, shallow_levels, timestamps, shallow, 50);
+
+	// the replayed book is reused across episodes, so the deep file's lower levels must not survive the switch
+	for (const auto& file : {csvfile, binfile, blkfile, dltfile}) {
+		SimExchange exch("data.csv", 0, 0, 100);
+		exch.reset();
+		OrderBook book;
+		size_t slot;
+		REQUIRE(exch.next_read(slot, book));
+		CHECK(book.bid_prices[levels - 1] > 0);
+
+		exch.setEpisode(file, 30);
+		exch.reset();
+		for (int ii = 0; ii < 5; ++ii) {
+			REQUIRE(exch.next_read(slot, book));
+			CHECK(book.bid_prices[0] == shallow[BID_PRICE][31 + ii]);
+			for (size_t level = shallow_levels; level < OrderBook::MAX_LEVELS; ++level) {
+				CHECK(book.bid_prices[level] == 0);
+				CHECK(book.ask_prices[level] == 0);
+				CHECK(book.bid_sizes[level] == 0);
+				CHECK(book.ask_sizes[level] == 0);
+			}
+		}
+
+		// a market order only walks the levels the file has
+		exch.market(7, OrderSide::BUY, 0, 1e9);
+		REQUIRE(exch.next_read(slot, book));
+		REQUIRE(exch.next_read(slot, book));
+		std::vector<Order> fills;
+		exch.getFills(fills);
+		REQUIRE(fills.size() == 1);
+		CHECK(exch.getLevelFills().size() == shallow_levels);
+	}
+
+	std::filesystem::remove_all(folder);
+}
+
+TEST_CASE("testing the merged reader") {
+	size_t levels = 0;
+	std::vector<long long> timestamps;
+	std::vector<std::vector<double>> columns;
+	TickConverter::readCsv("data.csv", levels, timestamps, columns);
+
+	// second instrument ticks half way between the first one's rows, with a delta encoded book
+	std::vector<long long> shifted(timestamps);
+	for (auto& timestamp : shifted) timestamp += 1;
+	auto dltfile = (std::filesystem::temp_directory_path() / "litepool_merged_test.dlt").string();
+	DeltaFile::write(dltfile, levels, shifted, columns, 50);
+
+	std::vector<std::unique_ptr<BaseReader>> readers;
+	readers.push_back(std::make_unique<CsvReader>("data.csv", 0, 120));
+	readers.push_back(std::make_unique<DeltaReader>(dltfile, 0, 120));
+	MergedReader merged(std::move(readers));
+	CHECK(merged.instruments() == 2);
+
+	TickFile reference(levels, timestamps, columns);
+	for (int episode = 0; episode < 2; ++episode) {
+		merged.reset();
+		std::vector<size_t> rows = {0, 0};
+		size_t events = 0;
+		long long last_timestamp = 0;
+		while (true) {
+			auto source = merged.source();
+			CHECK(merged.getTimeStamp() >= last_timestamp);
+			CHECK(merged.getTimeStamp() == timestamps[rows[source]] + static_cast<long long>(source));
+			last_timestamp = merged.getTimeStamp();
+			for (size_t instrument = 0; instrument < 2; ++instrument) {
+				if (instrument != source && rows[instrument] == 0) continue;
+				size_t row = instrument == source ? rows[instrument] : rows[instrument] - 1;
+				const auto& book = merged.book(instrument);
+				for (size_t level = 0; level < levels; ++level) {
+					CHECK(book.bid_prices[level] == reference.column(level, BID_PRICE)[row]);
+					CHECK(book.ask_sizes[level] == reference.column(level, ASK_AMOUNT)[row]);
+				}
+			}
+			++rows[source];
+			++events;
+			if (!merged.hasNext()) break;
+			merged.advance();
+		}
+		CHECK(events == 242);
+		CHECK(rows[0] == 121);
+		CHECK(rows[1] == 121);
+	}
+
+	// an instrument whose file starts later begins on its first row at or after the first one's start time
+	std::vector<long long> later(shifted.begin() + 25, shifted.end());
+	std::vector<std::vector<double>> later_columns;
+	for (const auto& column : columns) later_columns.emplace_back(column.begin() + 25, column.end());
+	std::vector<std::unique_ptr<BaseReader>> aligned_readers;
+	aligned_readers.push_back(std::make_unique<CsvReader>("data.csv", 0, 120));
+	aligned_readers.push_back(std::make_unique<TickReader>(std::make_shared<const TickFile>(levels, later, later_columns), 0, 120));
+	MergedReader aligned(std::move(aligned_readers));
+	auto expected = static_cast<size_t>(std::lower_bound(later.begin(), later.end(), timestamps[40]) - later.begin());
+	aligned.seek(40);
+	CHECK(aligned.source() == 0);
+	CHECK(aligned.getTimeStamp() == timestamps[40]);
+	aligned.advance();
+	CHECK(aligned.source() == 1);
+	CHECK(aligned.getRow() == expected);
+	CHECK(aligned.getTimeStamp() == later[expected]);
+	CHECK(aligned.book(1).bid_prices[0] == later_columns[BID_PRICE][expected]);
+
+	std::filesystem::remove(dltfile);
+}
+
+TEST_CASE("testing reader rows by time") {
+	size_t levels = 0;
+	std::vector<long long> timestamps;
+	std::vector<std::vector<double>> columns;
+	TickConverter::readCsv("data.csv", levels, timestamps, columns);
+
+	// the delta encoded copy ticks one unit after the others
+	std::vector<long long> shifted(timestamps);
+	for (auto& timestamp : shifted) timestamp += 1;
+	auto dltfile = (std::filesystem::temp_directory_path() / "litepool_rows_test.dlt").string();
+	DeltaFile::write(dltfile, levels, shifted, columns, 50);
+
+	// every reader finds the same row for a time
+	auto blkfile = (std::filesystem::temp_directory_path() / "litepool_rows_test.blk").string();
+	BlockFile::write(blkfile, levels, timestamps, columns, 16);
+	CsvReader csv("data.csv", 0, 120);
+	BlockReader block(blkfile, 0, 120);
+	DeltaReader delta(dltfile, 0, 120);
+	TickReader tick(std::make_shared<const TickFile>(levels, timestamps, columns), 0, 120);
+	for (size_t row : {size_t(0), size_t(1), size_t(17), size_t(40), size_t(300), timestamps.size() - 1}) {
+		auto at = static_cast<size_t>(std::lower_bound(timestamps.begin(), timestamps.end(), timestamps[row]) - timestamps.begin());
+		CHECK(csv.rowAt(timestamps[row]) == at);
+		CHECK(block.rowAt(timestamps[row]) == at);
+		CHECK(tick.rowAt(timestamps[row]) == at);
+		CHECK(delta.rowAt(timestamps[row] + 1) == at);
+	}
+	CHECK(tick.rowAt(timestamps.back() + 1) == timestamps.size() - 1);
+	CHECK(block.rowAt(timestamps.back() + 1) == timestamps.size() - 1);
+	CHECK(delta.rowAt(timestamps.back() + 2) == timestamps.size() - 1);
+	CHECK(csv.rowAt(timestamps.back() + 1) == timestamps.size() - 1);
+	CHECK(tick.rowAt(0) == 0);
+
+	// skipping lands on the same row and book as stepping, across blocks and snapshots and up to the read cap
+	BlockReader prefetched(blkfile, 0, 120, 2);
+	TickFile reference(levels, timestamps, columns);
+	std::vector<BaseReader*> readers{&csv, &block, &prefetched, &delta, &tick};
+	for (BaseReader* reader : readers) {
+		reader->seek(5);
+		size_t row = 5;
+		for (size_t rows : {size_t(3), size_t(40), size_t(60), size_t(1000)}) {
+			size_t moved = reader->skip(rows);
+			CHECK(moved == std::min(rows, size_t(125) - row));
+			row += moved;
+			CHECK(reader->getRow() == row);
+			OrderBook book;
+			reader->toBook(book);
+			CHECK(book.bid_sizes[2] == reference.column(2, BID_AMOUNT)[row]);
+			CHECK(book.ask_prices[4] == reference.column(4, ASK_PRICE)[row]);
+		}
+		CHECK_FALSE(reader->hasNext());
+		CHECK(reader->skip(1) == 0);
+	}
+	std::filesystem::remove(blkfile);
+	std::filesystem::remove(dltfile);
+}
+
+TEST_CASE("testing the market feature store") {
+	auto csvfile = (std::filesystem::temp_directory_path() / "litepool_features_test.csv").string();
+	std::filesystem::copy_file("data.csv", csvfile, std::filesystem::copy_options::overwrite_existing);
+	std::filesystem::remove(FeatureStore::featureFile(csvfile));
+
+	auto same = [](const double* lhs, const double* rhs, size_t count) {
+		for (size_t ii = 0; ii < count; ++ii) {
+			if (lhs[ii] != rhs[ii] && !(std::isnan(lhs[ii]) && std::isnan(rhs[ii]))) return false;
+		}
+		return true;
+	};
+
+	auto store = FeatureStore::get(csvfile);
+	CHECK(store == FeatureStore::get(csvfile));
+	CHECK(store->rows() == 1997);
+	CHECK(store->width() == MarketSignalBuilder::NUM_SIGNALS);
+	CHECK(std::filesystem::exists(FeatureStore::featureFile(csvfile)));
+
+	MarketSignalBuilder builder;
+	CsvReader reader(csvfile, 0, 300);
+	reader.reset();
+	while (true) {
+		OrderBook book;
+		reader.toBook(book);
+		auto signals = builder.add_book(book);
+		REQUIRE(signals.size() == store->width());
+		CHECK(same(signals.data(), store->row(reader.getRow()), signals.size()));
+		if (!reader.hasNext()) break;
+		reader.advance();
+	}
+
+	// a second open maps the sidecar instead of recomputing it
+	FeatureStore mapped(csvfile);
+	CHECK(mapped.rows() == store->rows());
+	CHECK(same(mapped.row(1996), store->row(1996), store->width()));
+	CHECK_THROWS_AS((void)mapped.row(mapped.rows()), std::out_of_range);
+
+	SimExchange live_exch(csvfile, 5, 0, 200);
+	SimExchange stored_exch(csvfile, 5, 0, 200, false, 0, true);
+	CHECK(live_exch.marketSignals() == nullptr);
+	InverseInstrument instr("BTC", 0.5, 10.0, 0, 0.0005);
+	Strategy live_strategy(instr, live_exch, 1, 5);
+	Strategy stored_strategy(instr, stored_exch, 1, 5);
+	EnvAdaptor live(live_strategy, live_exch);
+	EnvAdaptor stored(stored_strategy, stored_exch);
+	live.reset();
+	stored.reset();
+	std::array<double, 196> live_state{};
+	std::array<double, 196> stored_state{};
+	// a step reads two rows, the first ones of an episode build their signals live from an empty history,
+	// then the state holds the stored row of the last book read and position and trade signals stay live
+	const size_t width = MarketSignalBuilder::NUM_SIGNALS;
+	for (int ii = 0; ii < 50; ++ii) {
+		CHECK(live.next() == stored.next());
+		live.getState(live_state);
+		stored.getState(stored_state);
+		bool warming_up = 2 * (ii + 1) <= static_cast<int>(MarketSignalBuilder::HISTORY_ROWS);
+		CHECK((stored_exch.marketSignals() == nullptr) == warming_up);
+		if (warming_up) {
+			CHECK(same(live_state.data(), stored_state.data(), live_state.size()));
+		} else {
+			CHECK(same(stored_state.data(), store->row(2 * ii + 2), width));
+			CHECK(same(live_state.data() + width, stored_state.data() + width, live_state.size() - width));
+		}
+	}
+	CHECK(std::any_of(live_state.begin(), live_state.end(), [](double value) { return value != 0; }));
+
+	// the lagged signals look back from the latest book, so a live builder agrees with the stored rows
+	// after the warm up whichever row the episode starts on
+	const size_t start = MarketSignalBuilder::HISTORY_ROWS + 17;
+	live_exch.setEpisode(csvfile, start);
+	stored_exch.setEpisode(csvfile, start);
+	live.reset();
+	stored.reset();
+	for (int ii = 0; ii < 50; ++ii) {
+		CHECK(live.next() == stored.next());
+		live.getState(live_state);
+		stored.getState(stored_state);
+		CHECK(same(live_state.data(), stored_state.data(), live_state.size()));
+	}
+	CHECK(stored_exch.marketSignals() == store->row(start + 100));
+
+	std::filesystem::remove(FeatureStore::featureFile(csvfile));
+	std::filesystem::remove(LineIndex::indexFile(csvfile));
+	std::filesystem::remove(csvfile);
+}
+
+TEST_CASE("testing the tick converter") {
+	auto input = std::filesystem::temp_directory_path() / "litepool_converter_in";
+	auto output = std::filesystem::temp_directory_path() / "litepool_converter_out";
+	std::filesystem::create_directories(input);
+	std::filesystem::copy_file("data.csv", input / "1.csv", std::filesystem::copy_options::overwrite_existing);
+	std::filesystem::copy_file("data.csv", input / "2.csv", std::filesystem::copy_options::overwrite_existing);
+
+	auto summaries = TickConverter::convertFolder(input.string(), output.string(), 2);
+	CHECK(summaries.size() == 2);
+	CHECK(summaries[0].filename == "1.bin");
+	CHECK(summaries[0].rows == summaries[1].rows);
+	CHECK(summaries[0].first_timestamp == 1714348800182912);
+	CHECK(std::filesystem::exists(output / TickConverter::MANIFEST));
+
+	TickFile file((output / "1.bin").string());
+	CHECK(file.rows() == summaries[0].rows);
+	CHECK(file.levels() == 5);
+	CHECK(file.column(0, BID_PRICE)[0] == Approx(63100));
+	CHECK(file.column(1, BID_PRICE)[0] == Approx(63099.5));
+	CHECK(file.column(4, BID_AMOUNT)[0] == Approx(12080));
+
+	std::filesystem::remove_all(input);
+	std::filesystem::remove_all(output);
+}
+
+TEST_CASE("testing the shared dataset cache") {
+	{
+		auto first = DatasetCache::get("data.csv");
+		auto second = DatasetCache::get("./data.csv");
+		CHECK(first.get() == second.get());
+		CHECK(first->levels() == 5);
+		CHECK(first->timestamps()[0] == 1714348800182912);
+		CHECK(DatasetCache::size() == 1);
+	}
+	CHECK(DatasetCache::size() == 0);
+
+	SimExchange csv_exch("data.csv", 5, 0, 100);
+	SimExchange shared_exch("data.csv", 5, 0, 100, true);
+	SimExchange other_exch("data.csv", 5, 0, 100, true);
+	CHECK(DatasetCache::size() == 1);
+	OrderBook csv_book;
+	OrderBook shared_book;
+	size_t slot;
+	int counter = 0;
+	while (csv_exch.next_read(slot, csv_book)) {
+		CHECK(shared_exch.next_read(slot, shared_book));
+		CHECK(shared_book.bid_prices[0] == csv_book.bid_prices[0]);
+		CHECK(shared_book.ask_sizes[4] == csv_book.ask_sizes[4]);
+		++counter;
+	}
+	CHECK_FALSE(shared_exch.next_read(slot, shared_book));
+	CHECK(counter == 100);
+	CHECK(other_exch.next_read(slot, shared_book));
+	CHECK(shared_book.bid_prices[1] == Approx(63099.5));
+}
+
+TEST_CASE("testing the line offset index") {
+	auto csvfile = std::filesystem::temp_directory_path() / "litepool_index_test.csv";
+	std::filesystem::copy_file("data.csv", csvfile, std::filesystem::copy_options::overwrite_existing);
+	std::filesystem::remove(LineIndex::indexFile(csvfile.string()));
+
+	std::vector<std::string> lines;
+	{
+		std::ifstream in(csvfile);
+		std::string line;
+		std::getline(in, line);
+		while (std::getline(in, line)) lines.push_back(line);
+	}
+
+	{
+		LineIndex index(csvfile.string());
+		CHECK(index.lines() == lines.size());
+		CHECK(std::filesystem::exists(LineIndex::indexFile(csvfile.string())));
+		std::ifstream in(csvfile);
+		for (size_t ii : {size_t(0), size_t(1), size_t(777), lines.size() - 1}) {
+			std::string line;
+			in.seekg(static_cast<std::streamoff>(index.offset(ii)));
+			std::getline(in, line);
+			CHECK(line == lines[ii]);
+		}
+	}
+
+	{
+		std::ofstream out(csvfile, std::ios::app);
+		out << lines.back() << "\n";
+	}
+	std::filesystem::last_write_time(csvfile, std::filesystem::last_write_time(csvfile) + std::chrono::seconds(1));
+	LineIndex stale(csvfile.string());
+	CHECK(stale.lines() == lines.size() + 1);
+
+	std::set<long long> timestamps;
+	for (const auto& line : lines) timestamps.insert(std::stoll(line.substr(0, line.find(','))));
+	CsvReader reader(csvfile.string(), 1500, 10);
+	for (int ii = 0; ii < 20; ++ii) {
+		reader.reset();
+		CHECK(timestamps.count(reader.getTimeStamp()) == 1);
+		CHECK(reader.getTimeStamp() >= std::stoll(lines[0].substr(0, lines[0].find(','))));
+	}
+	CsvReader from_start(csvfile.string(), 0, 10);
+	from_start.reset();
+	CHECK(from_start.getTimeStamp() == 1714348800182912);
+
+	// malformed lines are not rows, so csv rows line up with the rows of the converted data
+	{
+		std::ifstream in("data.csv");
+		std::ofstream out(csvfile, std::ios::trunc);
+		std::string line;
+		for (size_t ii = 0; std::getline(in, line); ++ii) {
+			out << line << "\n";
+			if (ii == 10) out << "garbage\n";
+			if (ii == 500) out << line.substr(0, line.rfind(',')) << "\n";
+		}
+	}
+	std::filesystem::last_write_time(csvfile, std::filesystem::last_write_time(csvfile) + std::chrono::seconds(2));
+	size_t levels = 0;
+	std::vector<long long> converted;
+	std::vector<std::vector<double>> columns;
+	TickConverter::readCsv(csvfile.string(), levels, converted, columns);
+	CHECK(converted.size() == lines.size());
+	{
+		LineIndex index(csvfile.string());
+		REQUIRE(index.lines() == converted.size());
+		CHECK(std::equal(converted.begin(), converted.end(), index.timestamps()));
+	}
+
+	CsvReader skipping(csvfile.string(), 0, 2000);
+	skipping.seek(5);
+	while (true) {
+		CHECK(skipping.getTimeStamp() == converted[skipping.getRow()]);
+		if (!skipping.hasNext()) break;
+		skipping.advance();
+	}
+	CHECK(skipping.getRow() == converted.size() - 1);
+	skipping.seek(700);
+	CHECK(skipping.getTimeStamp() == converted[700]);
+	CHECK(skipping.rowAt(converted[700]) == 700);
+
+	// rows are found by time from the index alone, without opening the csv file
+	auto moved = csvfile;
+	moved += ".moved";
+	std::filesystem::rename(csvfile, moved);
+	CHECK(skipping.rowAt(converted[900]) == 900);
+	CHECK(skipping.rowAt(converted.back() + 1) == converted.size() - 1);
+	std::filesystem::rename(moved, csvfile);
+
+	std::filesystem::remove(csvfile);
+	std::filesystem::remove(LineIndex::indexFile(csvfile.string()));
+}
+
+TEST_CASE("testing the csv prefetcher") {
+	auto csvfile = std::filesystem::temp_directory_path() / "litepool_prefetch_test.csv";
+	{
+		std::ifstream in("data.csv");
+		std::ofstream out(csvfile, std::ios::trunc);
+		std::string header;
+		std::getline(in, header);
+		out << header << "\n";
+		std::string line;
+		std::vector<std::string> lines;
+		while (std::getline(in, line)) lines.push_back(line);
+		for (int copy = 0; copy < 5; ++copy) {
+			for (const auto& row : lines) out << row << "\n";
+		}
+	}
+
+	CsvReader plain(csvfile.string(), 0, 100000);
+	CsvReader prefetched(csvfile.string(), 0, 100000, 2);
+	for (int episode = 0; episode < 2; ++episode) {
+		plain.reset();
+		prefetched.reset();
+		int counter = 0;
+		while (plain.hasNext()) {
+			CHECK(prefetched.hasNext());
+			const auto& expected = plain.next();
+			const auto& row = prefetched.next();
+			CHECK(row.id == expected.id);
+			CHECK(row.askAmount(0) == expected.askAmount(0));
+			++counter;
+		}
+		CHECK_FALSE(prefetched.hasNext());
+		CHECK(counter > 2500 * 3);
+	}
+
+	int produced = 0;
+	Prefetcher<std::vector<int>> failing([&produced](std::vector<int>& batch) {
+		if (++produced > 2) throw std::runtime_error("broken batch");
+		batch.assign(3, produced);
+		return true;
+	}, 1);
+	std::vector<int> batch;
+	CHECK(failing.pop(batch));
+	CHECK(batch[0] == 1);
+	CHECK(failing.pop(batch));
+	CHECK(batch[0] == 2);
+	CHECK_THROWS_AS(failing.pop(batch), std::runtime_error);
+
+	std::filesystem::remove(csvfile);
+	std::filesystem::remove(LineIndex::indexFile(csvfile.string()));
+}
+
 TEST_CASE("testing the normal position") {
 	NormalInstrument instr("BTCUSDT", 0.1, 0.0001, -0.0001, 0.00075);
 	Position pos(instr, 2000, 0, 0);
@@ -293,7 +1102,7 @@ TEST_CASE("testing the normal position") {
 		Order order;
 		order.amount = 0.001;
 		order.microSecond = 1;
-		order.orderId = "1";
+		order.orderId = 1;
 		order.price = 1000.0;
 		order.side = OrderSide::BUY;
 		order.state = OrderState::FILLED;
@@ -320,7 +1129,7 @@ TEST_CASE("testing the normal position") {
 			Order order;
 			order.amount = 0.1;
 			order.microSecond = 1;
-			order.orderId = "1";
+			order.orderId = 1;
 			order.price = 1000.0;
 			order.side = OrderSide::BUY;
 			order.state = OrderState::FILLED;
@@ -344,7 +1153,7 @@ TEST_CASE("testing the normal position") {
 		Order order;
 		order.amount = 0.2;
 		order.microSecond = 1;
-		order.orderId = "1";
+		order.orderId = 1;
 		order.price = 1015.0;
 		order.side = OrderSide::SELL;
 		order.state = OrderState::FILLED;
@@ -392,7 +1201,7 @@ TEST_CASE("testing the inverse position") {
 		Order order;
 		order.amount = 10.0;
 		order.microSecond = 1;
-		order.orderId = "1";
+		order.orderId = 1;
 		order.price = 1000.0;
 		order.side = OrderSide::BUY;
 		order.state = OrderState::FILLED;
@@ -418,7 +1227,7 @@ TEST_CASE("testing the inverse position") {
 			Order order;
 			order.amount = 10.0;
 			order.microSecond = 1;
-			order.orderId = "1";
+			order.orderId = 1;
 			order.price = 1000.0;
 			order.side = OrderSide::BUY;
 			order.state = OrderState::FILLED;
@@ -441,7 +1250,7 @@ TEST_CASE("testing the inverse position") {
 		Order order;
 		order.amount = 15.0;
 		order.microSecond = 1;
-		order.orderId = "1";
+		order.orderId = 1;
 		order.price = 1015.0;
 		order.side = OrderSide::SELL;
 		order.state = OrderState::FILLED;
@@ -467,7 +1276,7 @@ TEST_CASE("testing the inverse position") {
 			Order order;
 			order.amount = 10.0;
 			order.microSecond = 1;
-			order.orderId = "1";
+			order.orderId = 1;
 			order.price = 1000.0;
 			order.side = OrderSide::SELL;
 			order.state = OrderState::FILLED;
@@ -490,7 +1299,7 @@ TEST_CASE("testing the inverse position") {
 		Order order;
 		order.amount = 15.0;
 		order.microSecond = 1;
-		order.orderId = "1";
+		order.orderId = 1;
 		order.price = 1015.0;
 		order.side = OrderSide::BUY;
 		order.state = OrderState::FILLED;
@@ -509,7 +1318,7 @@ TEST_CASE("testing the inverse position") {
 			Order order;
 			order.amount = 10.0;
 			order.microSecond = 1;
-			order.orderId = "1";
+			order.orderId = 1;
 			order.price = 1000.0;
 			order.side = OrderSide::BUY;
 			order.state = OrderState::FILLED;
@@ -526,7 +1335,7 @@ TEST_CASE("testing the inverse position") {
 		Order order;
 		order.amount = 10.0;
 		order.microSecond = 1;
-		order.orderId = "1";
+		order.orderId = 1;
 		order.price = 1015.0;
 		order.side = OrderSide::SELL;
 		order.state = OrderState::FILLED;
@@ -545,7 +1354,7 @@ TEST_CASE("testing the inverse position") {
 			Order order;
 			order.amount = 10.0;
 			order.microSecond = 1;
-			order.orderId = "1";
+			order.orderId = 1;
 			order.price = 1015.0;
 			order.side = OrderSide::SELL;
 			order.state = OrderState::FILLED;
@@ -562,7 +1371,7 @@ TEST_CASE("testing the inverse position") {
 		Order order;
 		order.amount = 10.0;
 		order.microSecond = 1;
-		order.orderId = "1";
+		order.orderId = 1;
 		order.price = 1000.0;
 		order.side = OrderSide::BUY;
 		order.state = OrderState::FILLED;
@@ -581,7 +1390,7 @@ TEST_CASE("testing the inverse position") {
 			Order order;
 			order.amount = 10.0;
 			order.microSecond = 1;
-			order.orderId = "1";
+			order.orderId = 1;
 			order.price = 1015.0;
 			order.side = OrderSide::SELL;
 			order.state = OrderState::FILLED;
@@ -598,7 +1407,7 @@ TEST_CASE("testing the inverse position") {
 		Order order;
 		order.amount = 20.0;
 		order.microSecond = 1;
-		order.orderId = "1";
+		order.orderId = 1;
 		order.price = 1000.0;
 		order.side = OrderSide::BUY;
 		order.state = OrderState::FILLED;
@@ -632,11 +1441,20 @@ TEST_CASE("testing exchange") {
 	exch.next_read(read_slot, next);
 	CHECK(next.bid_prices[0] == Approx(63100));
 	CHECK(next.bid_prices[1] == Approx(63099.5));
+
+	// the book is handed out by reference and patched in place row after row
+	const OrderBook* shared = exch.next_book(read_slot);
+	REQUIRE(shared != nullptr);
+	exch.done_read(read_slot);
+	CHECK(exch.next_book(read_slot) == shared);
+	CHECK(exch.next_read(read_slot, next));
+	CHECK(next.bid_sizes[0] == shared->bid_sizes[0]);
+	CHECK(next.ask_prices[4] == shared->ask_prices[4]);
 	exch.reset();
-	exch.quote("1", OrderSide::SELL, 42302, 100);
-	exch.quote("2", OrderSide::SELL, 42305, 500);
-	exch.quote("3", OrderSide::BUY, 40000, 300);
-	exch.quote("4", OrderSide::BUY, 39000, 200);
+	exch.quote(1, OrderSide::SELL, 42302, 100);
+	exch.quote(2, OrderSide::SELL, 42305, 500);
+	exch.quote(3, OrderSide::BUY, 40000, 300);
+	exch.quote(4, OrderSide::BUY, 39000, 200);
 	std::vector<Order> unacks = exch.getUnackedOrders();
 	CHECK(unacks.size() == 4);
 	size_t slot;
@@ -649,6 +1467,504 @@ TEST_CASE("testing exchange") {
 	CHECK(unacks.size() == 0);
 }
 
+TEST_CASE("testing order slots") {
+	OrderSlots slots;
+	Order order;
+	order.side = OrderSide::BUY;
+	order.price = 100;
+	order.amount = 10;
+
+	order.orderId = 1;
+	slots.insert(order);
+	order.orderId = 1 + OrderSlots::CAPACITY; // same home slot as id 1
+	slots.insert(order);
+	CHECK(slots.size() == 2);
+	CHECK(slots.slotOf(*slots.find(1)) != slots.slotOf(*slots.find(1 + OrderSlots::CAPACITY)));
+
+	order.price = 101;
+	slots.insert(order);
+	CHECK(slots.size() == 2);
+	CHECK(slots.find(1 + OrderSlots::CAPACITY)->price == Approx(101));
+
+	slots.erase(1);
+	CHECK(slots.find(1) == nullptr);
+	CHECK(slots.find(1 + OrderSlots::CAPACITY) != nullptr);
+
+	// erasing inside a chain keeps the orders after it reachable, and a new order takes the erased slot
+	order.orderId = 1 + 2 * OrderSlots::CAPACITY;
+	slots.insert(order);
+	size_t middle = slots.slotOf(*slots.find(1 + OrderSlots::CAPACITY));
+	slots.erase(1 + OrderSlots::CAPACITY);
+	CHECK(slots.find(1 + 2 * OrderSlots::CAPACITY) != nullptr);
+	order.orderId = 1 + 3 * OrderSlots::CAPACITY;
+	CHECK(slots.slotOf(slots.insert(order)) == middle);
+	order.price = 102;
+	slots.insert(order);
+	CHECK(slots.size() == 2);
+	CHECK(slots.find(1 + 3 * OrderSlots::CAPACITY)->price == Approx(102));
+
+	slots.clear();
+	for (OrderId id = 0; id < static_cast<OrderId>(OrderSlots::CAPACITY); ++id) {
+		order.orderId = id;
+		slots.insert(order);
+	}
+
+	size_t count = 0;
+	for (const Order& resting : slots) {
+		CHECK(slots.find(resting.orderId) == &resting);
+		++count;
+	}
+	CHECK(count == OrderSlots::CAPACITY);
+
+	order.orderId = OrderSlots::CAPACITY;
+	CHECK_THROWS(slots.insert(order));
+
+	// a full table has no free slot to end a probe on
+	slots.erase(5);
+	CHECK(slots.find(5) == nullptr);
+	slots.insert(order);
+	CHECK(slots.slotOf(*slots.find(OrderSlots::CAPACITY)) == 5);
+}
+
+TEST_CASE("testing ring queue") {
+	RingQueue<int> queue(4);
+	CHECK(queue.capacity() == 4);
+
+	// wrap around the ring without growing
+	for (int ii = 0; ii < 10; ++ii) {
+		queue.push(ii);
+		queue.push(ii + 100);
+		CHECK(queue.front() == ii);
+		queue.pop();
+		CHECK(queue.front() == ii + 100);
+		queue.pop();
+	}
+	CHECK(queue.empty());
+	CHECK(queue.capacity() == 4);
+
+	// growing keeps the arrival order
+	queue.push(-1);
+	queue.pop();
+	for (int ii = 0; ii < 9; ++ii) queue.push(ii);
+	CHECK(queue.size() == 9);
+	CHECK(queue.capacity() == 16);
+	for (int ii = 0; ii < 9; ++ii) {
+		CHECK(queue[0] == ii);
+		queue.pop();
+	}
+	CHECK_THROWS(queue.pop());
+}
+
+TEST_CASE("testing timing wheel") {
+	TimingWheel<int> wheel(8, 10);
+	std::vector<int> released;
+	auto collect = [&released](int value) { released.push_back(value); };
+
+	wheel.schedule(1005, 1);
+	wheel.schedule(1003, 2);
+	wheel.schedule(1015, 3);
+	wheel.schedule(1005 + 80, 4); // same slot as 1, one rotation later
+	CHECK(wheel.size() == 4);
+
+	wheel.release(1004, collect);
+	CHECK(released == std::vector<int>{2});
+
+	wheel.release(1020, collect);
+	CHECK(released == std::vector<int>{2, 1, 3});
+
+	// a due time already passed comes out on the next release
+	wheel.schedule(900, 5);
+	wheel.release(1021, collect);
+	CHECK(released.back() == 5);
+
+	// a jump of more than a rotation still finds everything due
+	wheel.release(5000, collect);
+	CHECK(released.back() == 4);
+	CHECK(wheel.empty());
+
+	wheel.schedule(6000, 6);
+	size_t pending = 0;
+	wheel.forEach([&pending](int) { ++pending; });
+	CHECK(pending == 1);
+	wheel.clear();
+	CHECK(wheel.empty());
+
+	// a gap of more than a rotation still releases in due order
+	TimingWheel<int> gapped;
+	std::vector<int> gapped_released;
+	gapped.schedule(100 * 128, 1);
+	gapped.schedule(101 * 128, 2);
+	gapped.release(356 * 128, [&gapped_released](int value) { gapped_released.push_back(value); });
+	CHECK(gapped_released == std::vector<int>{1, 2});
+
+	// values due at the same time come out in scheduling order
+	TimingWheel<int> tied;
+	std::vector<int> tied_released;
+	for (int ii = 0; ii < 40; ++ii) tied.schedule(ii % 2 == 0 ? 500 : 400, ii);
+	tied.release(600, [&tied_released](int value) { tied_released.push_back(value); });
+	REQUIRE(tied_released.size() == 40);
+	for (int ii = 0; ii < 20; ++ii) {
+		CHECK(tied_released[ii] == 2 * ii + 1);
+		CHECK(tied_released[20 + ii] == 2 * ii);
+	}
+}
+
+TEST_CASE("testing pending table") {
+	PendingTable pending(4);
+	Order order{};
+	order.state = OrderState::NEW;
+
+	// ids sharing a home slot, enough to grow the table
+	for (OrderId id = 0; id < 64; id += 8) {
+		order.orderId = id;
+		pending.add(order, 100 + id);
+	}
+	CHECK(pending.size() == 8);
+
+	order.orderId = 16;
+	order.state = OrderState::CANCELLED;
+	pending.add(order, 50);
+	const PendingTable::Entry* entry = pending.find(16);
+	REQUIRE(entry != nullptr);
+	CHECK(entry->due == 116);
+	CHECK(entry->requests == 2);
+	CHECK(entry->news == 1);
+
+	// erasing from the middle of a probe keeps the ids after it
+	order.orderId = 8;
+	order.state = OrderState::NEW;
+	pending.remove(order);
+	CHECK(pending.find(8) == nullptr);
+	for (OrderId id = 16; id < 64; id += 8) {
+		CHECK(pending.find(id) != nullptr);
+	}
+
+	order.orderId = 16;
+	pending.remove(order);
+	CHECK(pending.find(16)->news == 0);
+	order.state = OrderState::CANCELLED;
+	pending.remove(order);
+	CHECK(pending.find(16) == nullptr);
+	CHECK(pending.size() == 6);
+
+	pending.clear();
+	CHECK(pending.size() == 0);
+	CHECK(pending.find(0) == nullptr);
+}
+
+TEST_CASE("testing latency model") {
+	std::mt19937 gen(7);
+
+	auto constant = LatencyModel::parse("250");
+	CHECK(constant.kind() == LatencyModel::Kind::CONSTANT);
+	CHECK(constant.sample(gen) == 250);
+
+	auto lognormal = LatencyModel::parse("lognormal:300:0.5");
+	CHECK(lognormal.kind() == LatencyModel::Kind::LOGNORMAL);
+	std::vector<long long> samples;
+	for (int ii = 0; ii < 2001; ++ii) samples.push_back(lognormal.sample(gen));
+	std::nth_element(samples.begin(), samples.begin() + 1000, samples.end());
+	CHECK(samples[1000] == doctest::Approx(300).epsilon(0.1));
+
+	auto empirical = LatencyModel::parse("empirical:100:0,200:1,400:3");
+	CHECK(empirical.kind() == LatencyModel::Kind::EMPIRICAL);
+	int high = 0;
+	for (int ii = 0; ii < 1000; ++ii) {
+		auto latency = empirical.sample(gen);
+		CHECK(latency >= 100);
+		CHECK(latency <= 400);
+		if (latency > 200) ++high;
+	}
+	CHECK(high > 650);
+
+	CHECK_THROWS(LatencyModel::parse("lognormal:300"));
+	CHECK_THROWS(LatencyModel::parse("uniform:1:2"));
+	CHECK_THROWS(LatencyModel::parse("-5"));
+	CHECK_THROWS_AS(LatencyModel::empirical({100, 200}, {1, -1}), std::runtime_error);
+	CHECK_THROWS_AS(LatencyModel::empirical({100, 200}, {0, 0}), std::runtime_error);
+	CHECK_THROWS(LatencyModel::parse("empirical:100:0,200:0"));
+	CHECK_THROWS(LatencyModel::parse("empirical:100:-2,200:3"));
+
+	// a cancel slower than the ack leaves the quote resting a while longer
+	SimExchange exch("data.csv", 0, 0, 100);
+	exch.setLatency(LatencyModel(0), LatencyModel(100000000), LatencyModel(0), 1);
+	exch.reset();
+	exch.quote(1, OrderSide::BUY, 40000, 10);
+	OrderBook row;
+	size_t slot;
+	exch.next_read(slot, row);
+	CHECK(exch.getBidOrders().size() == 1);
+	exch.cancelOrders();
+	exch.next_read(slot, row);
+	CHECK(exch.getBidOrders().size() == 1);
+	CHECK(exch.getUnackedOrders().size() == 1);
+}
+
+TEST_CASE("testing queue position fills") {
+	OrderBook book;
+	book.bid_prices[0] = 100;
+	book.bid_sizes[0] = 5;
+	book.bid_prices[1] = 99;
+	book.bid_sizes[1] = 10;
+	book.bid_prices[2] = 98;
+	book.bid_sizes[2] = 20;
+
+	CHECK(QueueEngine::levelSize(book, OrderSide::BUY, 99) == Approx(10));
+	CHECK(QueueEngine::levelSize(book, OrderSide::BUY, 99.5) == Approx(0));
+	CHECK(QueueEngine::levelSize(book, OrderSide::BUY, 90) == Approx(-1));
+
+	QueueEngine queue;
+	Order order{};
+	order.side = OrderSide::BUY;
+	order.price = 99;
+	order.amount = 20;
+	queue.join(order, 3, book);
+	CHECK(queue.ahead(OrderSide::BUY, 3) == Approx(10));
+
+	book.bid_sizes[1] = 7;
+	CHECK(queue.onBook(order, 3, book, false) == Approx(0));
+	CHECK(queue.ahead(OrderSide::BUY, 3) == Approx(7));
+
+	// size joining the level queues behind us
+	book.bid_sizes[1] = 12;
+	CHECK(queue.onBook(order, 3, book, false) == Approx(0));
+	CHECK(queue.ahead(OrderSide::BUY, 3) == Approx(7));
+
+	book.bid_sizes[1] = 2;
+	CHECK(queue.onBook(order, 3, book, false) == Approx(3));
+	CHECK(queue.onPrint(order, 3, 5) == Approx(5));
+
+	// with prints driving, the book only trims what is ahead
+	queue.join(order, 4, book);
+	book.bid_sizes[1] = 1;
+	CHECK(queue.onBook(order, 4, book, true) == Approx(0));
+	CHECK(queue.ahead(OrderSide::BUY, 4) == Approx(1));
+	CHECK(queue.onPrint(order, 4, 3) == Approx(2));
+
+	// a quote at a level resting beyond the visible book waits for it to show
+	order.price = 90;
+	queue.join(order, 5, book);
+	CHECK(queue.onBook(order, 5, book, false) == Approx(0));
+	book.bid_prices[3] = 90;
+	book.bid_sizes[3] = 8;
+	CHECK(queue.onBook(order, 5, book, false) == Approx(0));
+	CHECK(queue.ahead(OrderSide::BUY, 5) == Approx(8));
+
+	// partial fills add up to at most the quote
+	SimExchange exch("data.csv", 5, 0, 1000, false, 0, false, false, true);
+	exch.reset();
+	OrderBook row;
+	size_t slot;
+	exch.next_read(slot, row);
+	exch.quote(1, OrderSide::BUY, row.bid_prices[0], 5000);
+	double filled = 0;
+	size_t fills = 0;
+	std::vector<Order> executions;
+	for (int ii = 0; ii < 500 && exch.next_read(slot, row); ++ii) {
+		exch.getFills(executions);
+		for (const auto& fill : executions) {
+			CHECK(fill.orderId == 1);
+			CHECK(fill.amount > 0);
+			filled += fill.amount;
+			++fills;
+		}
+	}
+	CHECK(fills > 0);
+	CHECK(filled <= 5000 + 0.00001);
+}
+
+TEST_CASE("testing market orders walk the book") {
+	SimExchange exch("data.csv", 0, 0, 100);
+	exch.reset();
+	OrderBook row;
+	size_t slot;
+	exch.next_read(slot, row);
+
+	const double amount = row.ask_sizes[0] + row.ask_sizes[1] + 1;
+	exch.market(7, OrderSide::BUY, 0, amount);
+	exch.next_read(slot, row);
+	const OrderBook walked = row;
+
+	// the levels come out with the fill they belong to
+	exch.next_read(slot, row);
+	CHECK(exch.getLevelFills().empty());
+	std::vector<Order> fills;
+	exch.getFills(fills);
+	REQUIRE(fills.size() == 1);
+	CHECK(fills[0].is_taker);
+	CHECK(fills[0].amount == Approx(amount));
+
+	const auto& levels = exch.getLevelFills();
+	REQUIRE(levels.size() == 3);
+	double notional = 0;
+	double total = 0;
+	for (size_t ii = 0; ii < levels.size(); ++ii) {
+		CHECK(levels[ii].orderId == 7);
+		CHECK(levels[ii].side == OrderSide::BUY);
+		CHECK(levels[ii].price == Approx(walked.ask_prices[ii]));
+		notional += levels[ii].price * levels[ii].amount;
+		total += levels[ii].amount;
+	}
+	CHECK(levels[0].amount == Approx(walked.ask_sizes[0]));
+	CHECK(levels[2].amount == Approx(1));
+	CHECK(total == Approx(amount));
+	CHECK(fills[0].price == Approx(notional / total));
+
+	// fetching again hands back emptied buffers
+	exch.getFills(fills);
+	CHECK(fills.empty());
+	CHECK(exch.getLevelFills().empty());
+
+	// a fill reported rows after the walk keeps its levels until then
+	SimExchange late("data.csv", 0, 0, 100);
+	late.reset();
+	late.setLatency(LatencyModel(0), LatencyModel(0), LatencyModel(200000), 1);
+	late.next_read(slot, row);
+	late.market(8, OrderSide::SELL, 0, row.bid_sizes[0] / 2);
+	size_t reads = 0;
+	do {
+		REQUIRE(late.next_read(slot, row));
+		late.getFills(fills);
+		CHECK(late.getLevelFills().size() == fills.size());
+		++reads;
+	} while (fills.empty());
+	CHECK(reads > 2);
+	CHECK(late.getLevelFills()[0].orderId == 8);
+	CHECK(late.getLevelFills()[0].amount == Approx(fills[0].amount));
+}
+
+TEST_CASE("testing market orders against an empty side") {
+	// a copy of data.csv without bids on the three rows read after the market order
+	auto csvfile = std::filesystem::temp_directory_path() / "litepool_empty_side_test.csv";
+	{
+		std::ifstream in("data.csv");
+		std::ofstream out(csvfile, std::ios::trunc);
+		std::string line;
+		std::getline(in, line);
+		out << line << "\n";
+		for (int ii = 0; ii < 50 && std::getline(in, line); ++ii) {
+			if (ii >= 2 && ii <= 4) {
+				std::stringstream ss(line);
+				std::string value;
+				for (int column = 0; std::getline(ss, value, ','); ++column) {
+					bool bid = column > 0 && (column - 1) % 4 >= 2;
+					out << (column > 0 ? "," : "") << (bid ? "0" : value);
+				}
+				out << "\n";
+			} else {
+				out << line << "\n";
+			}
+		}
+	}
+
+	SimExchange exch(csvfile.string(), 0, 0, 50);
+	exch.reset();
+	OrderBook row;
+	size_t slot;
+	exch.next_read(slot, row);
+	exch.market(3, OrderSide::SELL, 0, 100);
+
+	// nothing to sell into, so the order waits instead of filling at a zero price
+	std::vector<Order> fills;
+	for (int ii = 0; ii < 3; ++ii) {
+		exch.next_read(slot, row);
+		CHECK(row.bid_prices[0] == 0);
+		exch.getFills(fills);
+		CHECK(fills.empty());
+		CHECK(exch.isLive(3, OrderSide::SELL));
+	}
+
+	exch.next_read(slot, row);
+	const double best_bid = row.bid_prices[0];
+	REQUIRE(best_bid > 0);
+	exch.next_read(slot, row);
+	exch.getFills(fills);
+	REQUIRE(fills.size() == 1);
+	CHECK(fills[0].amount == Approx(100));
+	CHECK(fills[0].price == Approx(best_bid));
+
+	std::filesystem::remove(LineIndex::indexFile(csvfile.string()));
+	std::filesystem::remove(csvfile);
+}
+
+TEST_CASE("testing trade driven fills") {
+	auto folder = std::filesystem::temp_directory_path() / "litepool_trades";
+	std::filesystem::create_directories(folder);
+	auto bookfile = (folder / "book.csv").string();
+	std::filesystem::copy_file("data.csv", bookfile, std::filesystem::copy_options::overwrite_existing);
+	CHECK(TradeTape::tradeFile(bookfile) == (folder / "book.trades").string());
+
+	std::vector<long long> stamps;
+	CsvReader reader(bookfile, 0, 10);
+	reader.reset();
+	for (int ii = 0; ii < 8; ++ii) {
+		stamps.push_back(reader.getTimeStamp());
+		reader.advance();
+	}
+
+	{
+		std::ofstream out(TradeTape::tradeFile(bookfile));
+		out << "exchange,symbol,timestamp,local_timestamp,id,side,price,amount\n";
+		out << "deribit,BTC-PERPETUAL,0," << stamps[2] - 1 << ",1,sell,63100.0,60\n";
+		out << "deribit,BTC-PERPETUAL,0," << stamps[3] - 1 << ",2,sell,63100.0,30\n";
+		// malformed prints are skipped, a sell at price 0 would fill every resting bid
+		out << "deribit,BTC-PERPETUAL,0," << stamps[3] << ",6,sell,0,500\n";
+		out << "deribit,BTC-PERPETUAL,0," << stamps[3] << ",7,sell,63100.0,-5\n";
+		out << "deribit,BTC-PERPETUAL,0," << stamps[3] << ",8,sell\n";
+		out << "deribit,BTC-PERPETUAL,0,x" << stamps[3] << ",9,sell,63100.0,500\n";
+		out << "deribit,BTC-PERPETUAL,0," << stamps[3] << ",10,sell,abc,500\n";
+		out << "deribit,BTC-PERPETUAL,0," << stamps[3] << ",11,hold,63100.0,500\n";
+		out << "deribit,BTC-PERPETUAL,0," << stamps[4] - 1 << ",3,buy,63140.0,1000\n";
+		out << "deribit,BTC-PERPETUAL,0," << stamps[5] - 1 << ",4,sell,63100.0,10\n";
+		out << "deribit,BTC-PERPETUAL,0," << stamps[6] - 1 << ",5,buy,63151.0,1\n";
+	}
+
+	auto tape = TradeTape::get(TradeTape::tradeFile(bookfile));
+	CHECK(tape->size() == 5);
+	CHECK(tape->side(0) == OrderSide::SELL);
+	CHECK(tape->amount(2) == 1000);
+	CHECK(tape->after(stamps[2]) == 1);
+
+	SimExchange exch(bookfile, 5, 0, 100, false, 0, false, true);
+	exch.reset();
+	OrderBook book;
+	size_t slot;
+	exch.quote(1, OrderSide::BUY, 63100.0, 100);
+	exch.quote(2, OrderSide::SELL, 63150.0, 50);
+	CHECK(exch.next_read(slot, book));
+	CHECK(exch.getBidOrders().size() == 1);
+	CHECK(exch.getAskOrders().size() == 1);
+
+	// 60 and then 30 printed at the bid price is not enough for 100
+	CHECK(exch.next_read(slot, book));
+	CHECK(exch.next_read(slot, book));
+	CHECK(exch.getBidOrders().size() == 1);
+
+	// a buy print below the ask leaves it resting
+	CHECK(exch.next_read(slot, book));
+	CHECK(exch.getAskOrders().size() == 1);
+
+	CHECK(exch.next_read(slot, book));
+	CHECK(exch.getBidOrders().empty());
+	CHECK(exch.next_read(slot, book));
+	std::vector<Order> fills;
+	exch.getFills(fills);
+	REQUIRE(fills.size() == 1);
+	CHECK(fills[0].orderId == 1);
+	CHECK(fills[0].microSecond == stamps[5] - 1);
+
+	// printed through the ask price
+	CHECK(exch.getAskOrders().empty());
+	CHECK(exch.next_read(slot, book));
+	exch.getFills(fills);
+	REQUIRE(fills.size() == 1);
+	CHECK(fills[0].orderId == 2);
+	CHECK(fills[0].side == OrderSide::SELL);
+
+	tape.reset();
+	std::filesystem::remove_all(folder);
+}
+
 TEST_CASE("test of inverse strategy") {
 	SimExchange exch("data.csv", 5, 0, 1000);
 	OrderBook book;
@@ -678,3 +1994,602 @@ TEST_CASE("test of normal strategy") {
 	CHECK(bids.size() == 1);
 	CHECK(asks.size() == 1);
 }
+
+TEST_CASE("test of strategy amends") {
+	SimExchange exch("data.csv", 5, 0, 1000);
+	OrderBook book;
+	size_t slot;
+	exch.next_read(slot, book);
+	NormalInstrument instr("BTCUSDT", 0.1, .0001, -0.0001, 0.0075);
+	Strategy strategy(instr, exch, 2000,  5);
+	strategy.quote(2, 2, 1, 1, book.bid_prices, book.ask_prices);
+	exch.next_read(slot, book);
+	REQUIRE(exch.getBidOrders().size() == 1);
+	const OrderId bid_id = exch.getBidOrders().begin()->orderId;
+
+	// an unchanged quote sends nothing
+	strategy.quote(2, 2, 1, 1, book.bid_prices, book.ask_prices);
+	CHECK(exch.getUnackedOrders().empty());
+
+	// a new spread amends the working quote in place
+	strategy.quote(4, 2, 1, 1, book.bid_prices, book.ask_prices);
+	auto unacked = exch.getUnackedOrders();
+	REQUIRE(unacked.size() == 1);
+	CHECK(unacked[0].state == OrderState::AMEND);
+	CHECK(unacked[0].orderId == bid_id);
+	exch.next_read(slot, book);
+	REQUIRE(exch.getBidOrders().size() == 1);
+	CHECK(exch.getBidOrders().begin()->orderId == bid_id);
+	CHECK(exch.getBidOrders().begin()->state == OrderState::AMEND_ACK);
+	CHECK(exch.isLive(bid_id, OrderSide::BUY));
+
+	// no bid wanted cancels just that side
+	strategy.quote(2, 2, 0, 1, book.bid_prices, book.ask_prices);
+	exch.next_read(slot, book);
+	CHECK(exch.getBidOrders().empty());
+	CHECK(exch.getAskOrders().size() == 1);
+	CHECK_FALSE(exch.isLive(bid_id, OrderSide::BUY));
+
+	// an amend through the touch is rejected and the quote stays as it was
+	const OrderId ask_id = exch.getAskOrders().begin()->orderId;
+	const double ask_price = exch.getAskOrders().begin()->price;
+	exch.amend(ask_id, OrderSide::SELL, book.bid_prices[0] - 10, 1);
+	exch.next_read(slot, book);
+	REQUIRE(exch.getAskOrders().size() == 1);
+	CHECK(exch.getAskOrders().begin()->orderId == ask_id);
+	CHECK(exch.getAskOrders().begin()->price == Approx(ask_price));
+	CHECK(exch.isLive(ask_id, OrderSide::SELL));
+}
+
+TEST_CASE("test of amends after partial fills") {
+	SimExchange exch("data.csv", 5, 0, 1000, false, 0, false, false, true);
+	exch.reset();
+	OrderBook book;
+	size_t slot;
+	exch.next_read(slot, book);
+	exch.quote(1, OrderSide::BUY, book.bid_prices[0], 1000000);
+
+	// rest until part of the quote has filled
+	std::vector<Order> fills;
+	double filled = 0;
+	for (int ii = 0; ii < 500 && filled <= 0 && exch.next_read(slot, book); ++ii) {
+		exch.getFills(fills);
+		for (const auto& fill : fills) filled += fill.amount;
+	}
+	REQUIRE(filled > 0);
+	REQUIRE(filled < 1000000);
+	REQUIRE(exch.getBidOrders().size() == 1);
+	const double price = exch.getBidOrders().begin()->price;
+
+	// the amended size counts what the order filled already
+	exch.amend(1, OrderSide::BUY, price, 1200000);
+	exch.next_read(slot, book);
+	exch.getFills(fills);
+	for (const auto& fill : fills) filled += fill.amount;
+	REQUIRE(exch.getBidOrders().size() == 1);
+	const double resting = exch.getBidOrders().begin()->amount;
+	exch.next_read(slot, book);
+	exch.getFills(fills);
+	for (const auto& fill : fills) filled += fill.amount;
+	CHECK(resting + filled == Approx(1200000));
+
+	// an amend to no more than has filled leaves nothing to rest
+	exch.amend(1, OrderSide::BUY, price, filled / 2);
+	exch.next_read(slot, book);
+	CHECK(exch.getBidOrders().empty());
+	CHECK_FALSE(exch.isLive(1, OrderSide::BUY));
+}
+
+TEST_CASE("test of event driven steps") {
+	SimExchange exch("data.csv", 5, 0, 1500);
+	InverseInstrument instr("BTC", 0.5, 10.0, 0, 0.0005);
+	Strategy strategy(instr, exch, 1, 5);
+	EnvAdaptor adaptor(strategy, exch);
+	adaptor.reset();
+
+	// quiet market: the step runs a second of data time
+	adaptor.setEventStepping(1000000, 100000);
+	long long start = exch.getTimeStamp();
+	REQUIRE(adaptor.next());
+	CHECK(exch.getTimeStamp() - start >= 1000000);
+
+	// the row cap ends a step early
+	SimExchange replay("data.csv", 5, 0, 1500);
+	replay.reset();
+	OrderBook book;
+	size_t slot;
+	while (replay.getTimeStamp() < exch.getTimeStamp()) replay.next_read(slot, book);
+	for (int ii = 0; ii < 5; ++ii) replay.next_read(slot, book);
+	adaptor.setEventStepping(1000000000, 5);
+	REQUIRE(adaptor.next());
+	CHECK(exch.getTimeStamp() == replay.getTimeStamp());
+
+	// a fill ends the step on the row it is reported
+	exch.market(1, OrderSide::BUY, 0, 10);
+	start = exch.getTimeStamp();
+	REQUIRE(adaptor.next());
+	CHECK(strategy.getPosition().getTradeInfo().buy_trades == 1);
+	CHECK(exch.getTimeStamp() - start < 1000000000);
+
+	std::array<double, 196> state{};
+	adaptor.getState(state);
+	CHECK(std::any_of(state.begin(), state.end(), [](double value) { return value != 0; }));
+}
+
+TEST_CASE("test of fast forward") {
+	SimExchange fast_exch("data.csv", 5, 0, 1500);
+	SimExchange slow_exch("data.csv", 5, 0, 1500);
+	InverseInstrument instr("BTC", 0.5, 10.0, 0, 0.0005);
+	Strategy fast_strategy(instr, fast_exch, 1, 5);
+	Strategy slow_strategy(instr, slow_exch, 1, 5);
+	EnvAdaptor fast(fast_strategy, fast_exch);
+	EnvAdaptor slow(slow_strategy, slow_exch);
+	fast_exch.setEpisode("data.csv", 10);
+	slow_exch.setEpisode("data.csv", 10);
+	fast.reset();
+	slow.reset();
+
+	CHECK(fast_exch.isIdle());
+	REQUIRE(fast.advance(60));
+	for (int ii = 0; ii < 30; ++ii) REQUIRE(slow.next());
+	CHECK(fast_exch.getTimeStamp() == slow_exch.getTimeStamp());
+
+	std::array<double, 196> fast_state{};
+	std::array<double, 196> slow_state{};
+	fast.getState(fast_state);
+	slow.getState(slow_state);
+	for (size_t ii = 0; ii < fast_state.size(); ++ii) {
+		CHECK(fast_state[ii] == Approx(slow_state[ii]));
+	}
+
+	// an idle event step skips to the end of its interval and leaves the state of reading every row
+	fast.setEventStepping(1000000, 100000);
+	long long start = fast_exch.getTimeStamp();
+	REQUIRE(fast.next());
+	CHECK(fast_exch.getTimeStamp() - start >= 1000000);
+	while (slow_exch.getTimeStamp() < fast_exch.getTimeStamp()) REQUIRE(slow.advance(1));
+	CHECK(slow_exch.getTimeStamp() - start >= 1000000);
+	fast.getState(fast_state);
+	slow.getState(slow_state);
+	for (size_t ii = 0; ii < fast_state.size(); ++ii) {
+		CHECK(fast_state[ii] == Approx(slow_state[ii]));
+	}
+	fast.setEventStepping(0, 0);
+
+	// working orders take the usual path
+	fast_exch.quote(1, OrderSide::BUY, 40000, 10);
+	CHECK_FALSE(fast_exch.isIdle());
+	REQUIRE(fast.advance(10));
+	CHECK(fast_exch.getBidOrders().size() == 1);
+
+	// running out of data is reported
+	CHECK_FALSE(fast.advance(5000));
+
+	// the exchange skips rows in bulk and builds only the books of the last history rows
+	SimExchange bulk("data.csv", 5, 0, 1500);
+	SimExchange stepped("data.csv", 5, 0, 1500);
+	bulk.setEpisode("data.csv", 10);
+	stepped.setEpisode("data.csv", 10);
+	bulk.reset();
+	stepped.reset();
+	std::vector<OrderBook> books;
+	OrderBook book;
+	size_t slot;
+	CHECK(bulk.advance(100, 7, books) == 100);
+	REQUIRE(books.size() == 7);
+	for (size_t ii = 0; ii < 100; ++ii) {
+		REQUIRE(stepped.next_read(slot, book));
+		if (ii < 93) continue;
+		CHECK(books[ii - 93].bid_prices[0] == book.bid_prices[0]);
+		CHECK(books[ii - 93].ask_sizes[4] == book.ask_sizes[4]);
+	}
+	CHECK(bulk.getTimeStamp() == stepped.getTimeStamp());
+
+	// fewer rows than the history hand out every book, and reading carries on from the last one
+	CHECK(bulk.advance(3, 7, books) == 3);
+	CHECK(books.size() == 3);
+	for (int ii = 0; ii < 3; ++ii) REQUIRE(stepped.next_read(slot, book));
+	CHECK(books.back().bid_sizes[2] == book.bid_sizes[2]);
+	OrderBook next;
+	REQUIRE(bulk.next_read(slot, next));
+	REQUIRE(stepped.next_read(slot, book));
+	CHECK(next.bid_prices[3] == book.bid_prices[3]);
+	CHECK(next.ask_sizes[1] == book.ask_sizes[1]);
+}
+
+TEST_CASE("test of snapshot and restore") {
+	SimExchange exch("data.csv", 5, 0, 1500);
+	exch.setLatency(LatencyModel::lognormal(300, 0.5), LatencyModel(200), LatencyModel::lognormal(100, 0.5), 7);
+	InverseInstrument instr("BTC", 0.5, 10.0, 0, 0.0005);
+	Strategy strategy(instr, exch, 1, 5);
+	EnvAdaptor adaptor(strategy, exch);
+	exch.setEpisode("data.csv", 10);
+	adaptor.reset();
+
+	for (int ii = 0; ii < 20; ++ii) {
+		adaptor.quote(0, 0, 5, 5);
+		REQUIRE(adaptor.next());
+	}
+
+	// an order in flight at the snapshot
+	exch.market(1000, OrderSide::BUY, 0, 10);
+
+	auto exch_snap = std::make_unique<SimExchange::Snapshot>();
+	auto adaptor_snap = std::make_unique<EnvAdaptor::Snapshot>();
+	exch.snapshot(*exch_snap);
+	adaptor.snapshot(*adaptor_snap);
+
+	auto rollout = [&](std::vector<std::array<double, 196>>& states, std::vector<long long>& timestamps) {
+		for (int ii = 0; ii < 50; ++ii) {
+			adaptor.quote(ii % 3, (ii + 1) % 3, 5, 5);
+			if (ii % 10 == 5) exch.market(1001 + ii, OrderSide::SELL, 0, 10);
+			REQUIRE(adaptor.next());
+			states.emplace_back();
+			adaptor.getState(states.back());
+			timestamps.push_back(exch.getTimeStamp());
+		}
+	};
+
+	std::vector<std::array<double, 196>> first_states, second_states;
+	std::vector<long long> first_times, second_times;
+	rollout(first_states, first_times);
+	double first_balance = strategy.getPosition().getPositionInfo(40000, 40001).balance;
+
+	exch.restore(*exch_snap);
+	adaptor.restore(*adaptor_snap);
+	rollout(second_states, second_times);
+
+	CHECK(exch_snap->num_pending == 1);
+	CHECK(strategy.getPosition().getTradeInfo().sell_trades == 5);
+	CHECK(first_times == second_times);
+	CHECK(first_states == second_states);
+	CHECK(strategy.getPosition().getPositionInfo(40000, 40001).balance == first_balance);
+
+	// a later episode must not take the snapshot
+	exch.setEpisode("data.csv", 30);
+	adaptor.reset();
+	CHECK_THROWS_AS(exch.restore(*exch_snap), std::runtime_error);
+}
+
+TEST_CASE("test of journal replay") {
+	auto journal = (std::filesystem::temp_directory_path() / "litepool_journal_test.bin").string();
+	std::filesystem::remove(journal);
+	InverseInstrument instr("BTC", 0.5, 10.0, 0, 0.0005);
+
+	{
+		SimExchange exch("data.csv", 5, 0, 1500);
+		exch.setLatency(LatencyModel::lognormal(300, 0.5), LatencyModel(200), LatencyModel::lognormal(100, 0.5), 7);
+		JournalExchange journaled(exch, journal, 3);
+		Strategy strategy(instr, journaled, 1, 5);
+		EnvAdaptor adaptor(strategy, journaled);
+		exch.setEpisode("data.csv", 10);
+		adaptor.reset();
+		for (int ii = 0; ii < 80; ++ii) {
+			adaptor.quote(ii % 3, (ii + 1) % 3, 5, 5);
+			if (ii % 10 == 5) journaled.market(1000 + ii, ii % 20 == 5 ? OrderSide::SELL : OrderSide::BUY, 0, 10);
+			REQUIRE(adaptor.next());
+		}
+
+		// another env of the pool appends to the same file
+		SimExchange other_exch("data.csv", 5, 0, 1500);
+		JournalExchange other(other_exch, journal, 4);
+		other.reset();
+		other.market(1, OrderSide::BUY, 0, 10);
+	}
+
+	JournalReader reader(journal, 3);
+	CHECK(reader.episodes() == 1);
+	CHECK(reader.episode(0).filename == "data.csv");
+	CHECK(reader.episode(0).start_row == 10);
+	CHECK(JournalReader(journal).records().size() == reader.records().size() + 3);
+
+	// names longer than a record are split over several
+	const std::string long_name = "/data/deribit/btc-perpetual/2024-04-29/book_snapshot_25.csv.gz";
+	{
+		JournalWriter writer(journal, 5);
+		writer.recordEpisode(0, EpisodeStart{long_name, 42, 7});
+	}
+	CHECK(JournalReader(journal, 5).episode(0).filename == long_name);
+	CHECK(JournalReader(journal, 5).episode(0).seed == 7);
+
+	std::vector<JournalRecord> journaled_fills;
+	for (const auto& rec : reader.records()) {
+		CHECK(rec.env_id == 3);
+		if (rec.event == JournalEvent::FILL) journaled_fills.push_back(rec);
+	}
+	REQUIRE(journaled_fills.size() >= 8);
+
+	// the file, start row and latency seed come from the journal
+	SimExchange exch("data.csv", 5, 0, 1500);
+	exch.setLatency(LatencyModel::lognormal(300, 0.5), LatencyModel(200), LatencyModel::lognormal(100, 0.5), 99);
+	auto fills = reader.replay(exch);
+
+	REQUIRE(fills.size() == journaled_fills.size());
+	for (size_t ii = 0; ii < fills.size(); ++ii) {
+		CHECK(fills[ii].orderId == journaled_fills[ii].order_id);
+		CHECK(fills[ii].side == journaled_fills[ii].side);
+		CHECK(fills[ii].price == journaled_fills[ii].price);
+		CHECK(fills[ii].amount == journaled_fills[ii].amount);
+	}
+
+	CHECK_THROWS(reader.replay(exch, 1));
+	std::filesystem::remove(journal);
+}
+
+TEST_CASE("test of bucketed steps") {
+	const long long bucket = 100000;
+	SimExchange exch("data.csv", 5, 0, 1500);
+	InverseInstrument instr("BTC", 0.5, 10.0, 0, 0.0005);
+	Strategy strategy(instr, exch, 1, 5);
+	EnvAdaptor adaptor(strategy, exch);
+	adaptor.setBucketStepping(bucket, 1000);
+	exch.setEpisode("data.csv", 10);
+	adaptor.reset();
+
+	SimExchange replay("data.csv", 5, 0, 1500);
+	replay.setEpisode("data.csv", 10);
+	replay.reset();
+	MarketSignalBuilder builder;
+	OrderBook book;
+	size_t slot;
+
+	size_t steps = 0;
+	size_t rows = 0;
+	std::array<double, 196> state{};
+	while (true) {
+		// the step closes on the first row at or past the next bucket boundary
+		long long bucket_end = (replay.getTimeStamp() / bucket + 1) * bucket;
+		bool more = true;
+		do {
+			more = replay.next_read(slot, book);
+			rows += more ? 1 : 0;
+		} while (more && replay.getTimeStamp() < bucket_end);
+
+		adaptor.quote(1, 1, 5, 5);
+		if (!more) {
+			CHECK_FALSE(adaptor.next());
+			break;
+		}
+		REQUIRE(adaptor.next());
+		++steps;
+		CHECK(exch.getTimeStamp() == replay.getTimeStamp());
+
+		// only the bucket's closing book feeds the market signals
+		auto expected = builder.add_book(book);
+		adaptor.getState(state);
+		for (size_t ii = 0; ii < MarketSignalBuilder::NUM_SIGNALS; ++ii) {
+			CHECK(state[ii] == Approx(expected[ii]));
+		}
+	}
+
+	// several rows go into most steps
+	CHECK(steps > 0);
+	CHECK(rows > 3 * steps);
+
+	// the row cap ends a step before the bucket closes
+	SimExchange capped_exch("data.csv", 5, 0, 1500);
+	Strategy capped_strategy(instr, capped_exch, 1, 5);
+	EnvAdaptor capped(capped_strategy, capped_exch);
+	capped.setBucketStepping(bucket, 2);
+	capped_exch.setEpisode("data.csv", 10);
+	capped.reset();
+	size_t capped_steps = 0;
+	while (capped.next()) ++capped_steps;
+	CHECK(capped_steps > steps);
+	CHECK(capped_steps * 2 >= rows);
+
+	// precomputed row features follow every book, so bucketed steps build their signals live
+	auto csvfile = (std::filesystem::temp_directory_path() / "litepool_bucket_test.csv").string();
+	std::filesystem::copy_file("data.csv", csvfile, std::filesystem::copy_options::overwrite_existing);
+	SimExchange live_exch(csvfile, 5, 0, 1500);
+	SimExchange stored_exch(csvfile, 5, 0, 1500, false, 0, true);
+	Strategy live_strategy(instr, live_exch, 1, 5);
+	Strategy stored_strategy(instr, stored_exch, 1, 5);
+	EnvAdaptor live(live_strategy, live_exch);
+	EnvAdaptor stored(stored_strategy, stored_exch);
+	live.setBucketStepping(bucket, 1000);
+	stored.setBucketStepping(bucket, 1000);
+	live_exch.setEpisode(csvfile, 10);
+	stored_exch.setEpisode(csvfile, 10);
+	live.reset();
+	stored.reset();
+	std::array<double, 196> live_state{};
+	std::array<double, 196> stored_state{};
+	while (live.next()) {
+		REQUIRE(stored.next());
+		live.getState(live_state);
+		stored.getState(stored_state);
+		for (size_t ii = 0; ii < MarketSignalBuilder::NUM_SIGNALS; ++ii) {
+			CHECK(stored_state[ii] == Approx(live_state[ii]));
+		}
+	}
+	std::filesystem::remove(FeatureStore::featureFile(csvfile));
+	std::filesystem::remove(LineIndex::indexFile(csvfile));
+	std::filesystem::remove(csvfile);
+}
+
+TEST_CASE("test of grid quoting") {
+	SimExchange exch("data.csv", 5, 0, 1000);
+	OrderBook book;
+	size_t slot;
+	exch.next_read(slot, book);
+	NormalInstrument instr("BTCUSDT", 0.1, .0001, -0.0001, 0.0075);
+	Strategy strategy(instr, exch, 2000,  5);
+	strategy.setGrid(3, Strategy::parseProfile("3,2,1"));
+
+	// the ladder goes out as one batch of new orders
+	strategy.quote(2, 2, 6, 6, book.bid_prices, book.ask_prices);
+	CHECK(exch.getUnackedOrders().size() == 6);
+	const auto quoted = book;
+	exch.next_read(slot, book);
+	REQUIRE(exch.getBidOrders().size() == 3);
+	REQUIRE(exch.getAskOrders().size() == 3);
+
+	std::vector<Order> bids;
+	for (const Order& order : exch.getBidOrders()) bids.push_back(order);
+	std::sort(bids.begin(), bids.end(), [](const Order& lhs, const Order& rhs) { return lhs.price > rhs.price; });
+	for (size_t ii = 0; ii < bids.size(); ++ii) {
+		CHECK(bids[ii].price == Approx(quoted.bid_prices[2 + ii]));
+	}
+	CHECK(bids[0].amount == Approx(1.5 * bids[1].amount).epsilon(0.01));
+	CHECK(bids[0].amount == Approx(3 * bids[2].amount).epsilon(0.01));
+
+	// narrowing the grid cancels the outer levels
+	strategy.setGrid(1);
+	strategy.quote(2, 2, 6, 6, book.bid_prices, book.ask_prices);
+	exch.next_read(slot, book);
+	CHECK(exch.getBidOrders().size() == 1);
+	CHECK(exch.getAskOrders().size() == 1);
+
+	CHECK_THROWS(strategy.setGrid(0));
+	CHECK_THROWS(strategy.setGrid(Strategy::MAX_GRID_LEVELS + 1));
+	CHECK_THROWS(strategy.setGrid(2, {1}));
+	CHECK_THROWS(strategy.setGrid(2, {0, 0}));
+	CHECK_THROWS(Strategy::parseProfile("1,x"));
+}
+
+TEST_CASE("test of cancels not overtaking their order") {
+	SimExchange exch("data.csv", 5, 0, 1000);
+	exch.setLatency(LatencyModel(5000), LatencyModel(10), LatencyModel(0), 7);
+	OrderBook book;
+	size_t slot;
+	exch.next_read(slot, book);
+
+	exch.quote(1, OrderSide::BUY, book.bid_prices[2], 1);
+	exch.cancel(1, OrderSide::BUY);
+	for (int ii = 0; ii < 20; ++ii) exch.next_read(slot, book);
+	CHECK(exch.getBidOrders().empty());
+	CHECK_FALSE(exch.isLive(1, OrderSide::BUY));
+	CHECK(exch.isIdle());
+
+	// an amend waits for its order too
+	exch.quote(2, OrderSide::BUY, book.bid_prices[2], 1);
+	exch.amend(2, OrderSide::BUY, book.bid_prices[3], 2);
+	for (int ii = 0; ii < 20; ++ii) exch.next_read(slot, book);
+	REQUIRE(exch.getBidOrders().size() == 1);
+	CHECK(exch.getBidOrders().begin()->amount == Approx(2));
+}
+
+TEST_CASE("test of default fill reporting") {
+	SimExchange exch("data.csv", 5, 0, 1000);
+	OrderBook book;
+	size_t slot;
+	std::vector<Order> fills;
+	exch.next_read(slot, book);
+
+	// without a fill latency model a fill comes out on the row after it happens
+	exch.market(1, OrderSide::BUY, 0, 10);
+	exch.next_read(slot, book);
+	exch.getFills(fills);
+	CHECK(fills.empty());
+	exch.next_read(slot, book);
+	exch.getFills(fills);
+	CHECK(fills.size() == 1);
+}
+
+TEST_CASE("testing the deribit order requests") {
+	auto order = [](OrderId id, OrderSide side, double price, double amount, OrderState state, bool is_taker) {
+		Order request{};
+		request.orderId = id;
+		request.side = side;
+		request.price = price;
+		request.amount = amount;
+		request.state = state;
+		request.is_taker = is_taker;
+		return request;
+	};
+	auto report = [](const std::string& exchange_id, const std::string& label, const std::string& direction,
+	                 double price, double amount, const std::string& state) {
+		return json{{"order_id", exchange_id}, {"label", label}, {"direction", direction},
+		            {"price", price}, {"amount", amount}, {"order_state", state}, {"instrument_name", "BTC-PERPETUAL"}};
+	};
+	auto methods = [](const std::vector<json>& requests) {
+		std::vector<std::string> names;
+		for (const auto& request : requests) names.push_back(request["method"]);
+		return names;
+	};
+	using Methods = std::vector<std::string>;
+
+	DeribitOrders orders("BTC-PERPETUAL");
+	long long now = 1000;
+
+	// a new grid goes out as one labelled limit order per level
+	auto requests = orders.submit({order(1, OrderSide::BUY, 100, 10, OrderState::NEW, false),
+	                               order(2, OrderSide::SELL, 101, 10, OrderState::NEW, false)}, now);
+	CHECK(methods(requests) == Methods{"private/buy", "private/sell"});
+	CHECK(requests[0]["params"]["label"] == "buy-1");
+	CHECK(requests[0]["params"]["instrument_name"] == "BTC-PERPETUAL");
+	CHECK(requests[0]["params"]["type"] == "limit");
+	CHECK(requests[1]["params"]["price"] == 101.0);
+	CHECK(orders.isLive(1, OrderSide::BUY, now));
+	CHECK_FALSE(orders.isLive(1, OrderSide::SELL, now));
+
+	// an order not acked yet is replaced under its label, and cancelled by it
+	requests = orders.submit({order(1, OrderSide::BUY, 99.5, 10, OrderState::AMEND, false)}, now);
+	CHECK(methods(requests) == Methods{"private/cancel_by_label", "private/buy"});
+	CHECK(requests[0]["params"]["label"] == "buy-1");
+	CHECK(requests[1]["params"]["price"] == 99.5);
+
+	// once acked, a move is one edit of the Deribit order and a repeat within 0.001 sends nothing
+	orders.onOrder(report("ETH-1", "buy-1", "buy", 99.5, 10, "open"));
+	orders.onOrder(report("ETH-2", "sell-2", "sell", 101, 10, "open"));
+	CHECK(orders.strategyId("ETH-1", json::object()) == 1);
+	requests = orders.submit({order(1, OrderSide::BUY, 99.5005, 10.0005, OrderState::AMEND, false),
+	                          order(2, OrderSide::SELL, 101.5, 10, OrderState::AMEND, false)}, now);
+	CHECK(methods(requests) == Methods{"private/edit"});
+	CHECK(requests[0]["params"]["order_id"] == "ETH-2");
+	CHECK(requests[0]["params"]["price"] == 101.5);
+	CHECK(requests[0]["params"]["amount"] == 10.0);
+
+	// the amount Deribit reports overwrites the tracked one, so asking for the old amount again edits it back
+	orders.onOrder(report("ETH-1", "buy-1", "buy", 99.5, 6, "open"));
+	requests = orders.submit({order(1, OrderSide::BUY, 99.5, 10, OrderState::AMEND, false)}, now);
+	CHECK(methods(requests) == Methods{"private/edit"});
+	CHECK(requests[0]["params"]["order_id"] == "ETH-1");
+	CHECK(requests[0]["params"]["amount"] == 10.0);
+	orders.onOrder(report("ETH-1", "buy-1", "buy", 99.5, 10, "open"));
+	CHECK(orders.submit({order(1, OrderSide::BUY, 99.5, 10, OrderState::AMEND, false)}, now).empty());
+
+	// market orders are not tracked, cancels of acked orders go by Deribit id
+	requests = orders.submit({order(3, OrderSide::SELL, 0, 5, OrderState::NEW, true),
+	                          order(2, OrderSide::SELL, 0, 0, OrderState::CANCELLED, false)}, now);
+	CHECK(methods(requests) == Methods{"private/sell", "private/cancel"});
+	CHECK(requests[0]["params"]["type"] == "market");
+	CHECK(requests[0]["params"]["label"] == "sell-3");
+	CHECK(requests[1]["params"]["order_id"] == "ETH-2");
+	CHECK_FALSE(orders.isLive(2, OrderSide::SELL, now));
+	CHECK_FALSE(orders.isLive(3, OrderSide::SELL, now));
+
+	// a closed report ends the order, one for an order it already replaced does not
+	orders.onOrder(report("ETH-1", "buy-1", "buy", 99.5, 10, "filled"));
+	CHECK_FALSE(orders.isLive(1, OrderSide::BUY, now));
+	requests = orders.submit({order(1, OrderSide::BUY, 99, 10, OrderState::NEW, false)}, now);
+	CHECK(methods(requests) == Methods{"private/buy"});
+	orders.onOrder(report("ETH-3", "buy-1", "buy", 99, 10, "open"));
+	orders.onOrder(report("ETH-1", "buy-1", "buy", 99.5, 10, "cancelled"));
+	CHECK(orders.isLive(1, OrderSide::BUY, now));
+
+	// reports of orders placed outside the strategy are ignored
+	CHECK(orders.strategyId("ETH-9", report("ETH-9", "manual", "buy", 98, 1, "open")) == DeribitOrders::NO_ID);
+	orders.onOrder(report("ETH-9", "manual", "buy", 98, 1, "open"));
+	CHECK_FALSE(orders.isLive(DeribitOrders::NO_ID, OrderSide::BUY, now));
+
+	// an order never acked stops counting as live after the ack timeout, and asking for it again places it anew
+	requests = orders.submit({order(4, OrderSide::SELL, 102, 1, OrderState::NEW, false)}, now);
+	CHECK(methods(requests) == Methods{"private/sell"});
+	CHECK(requests[0]["params"]["label"] == "sell-4");
+	CHECK(requests[0]["params"]["price"] == 102.0);
+	CHECK(orders.isLive(4, OrderSide::SELL, now + DeribitOrders::ACK_TIMEOUT - 1));
+	CHECK(orders.submit({order(4, OrderSide::SELL, 102, 1, OrderState::AMEND, false)},
+	                    now + DeribitOrders::ACK_TIMEOUT - 1).empty());
+	CHECK_FALSE(orders.isLive(4, OrderSide::SELL, now + DeribitOrders::ACK_TIMEOUT));
+	requests = orders.submit({order(4, OrderSide::SELL, 102, 1, OrderState::AMEND, false)}, now + DeribitOrders::ACK_TIMEOUT);
+	CHECK(methods(requests) == Methods{"private/sell"});
+	CHECK(orders.isLive(4, OrderSide::SELL, now + DeribitOrders::ACK_TIMEOUT));
+	CHECK(orders.submit({}, now + 2 * DeribitOrders::ACK_TIMEOUT).empty());
+	CHECK_FALSE(orders.isLive(4, OrderSide::SELL, now + 2 * DeribitOrders::ACK_TIMEOUT));
+
+	// a cancel all forgets every live order
+	orders.cancelAll();
+	CHECK_FALSE(orders.isLive(1, OrderSide::BUY, now));
+}
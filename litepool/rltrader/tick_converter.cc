@@ -0,0 +1,164 @@
+#include "tick_converter.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <glog/logging.h>
+
+using namespace RLTrader;
+namespace fs = std::filesystem;
+
+void TickConverter::readCsv(const std::string& filename, size_t& levels,
+                            std::vector<long long>& timestamps,
+                            std::vector<std::vector<double>>& columns) {
+    std::ifstream filestream(filename, std::ios::in);
+    if (!filestream.is_open()) {
+        throw std::runtime_error("Could not open file " + filename);
+    }
+
+    std::string line;
+    if (!std::getline(filestream, line)) {
+        throw std::runtime_error("Failed to read header line");
+    }
+
+    // resolve every value header (the first one is the timestamp) to a tick column
+    std::vector<int> targets;
+    std::istringstream headerStream(line);
+    std::string header;
+    std::getline(headerStream, header, ',');
+    int max_column = -1;
+    while (std::getline(headerStream, header, ',')) {
+        if (!header.empty() && header.back() == '\r') header.pop_back();
+        int column = TickFile::columnOf(header);
+        targets.push_back(column);
+        max_column = std::max(max_column, column);
+    }
+
+    levels = static_cast<size_t>(max_column + 1) / NUM_FIELDS;
+    if (levels == 0 || std::count_if(targets.begin(), targets.end(), [](int c) { return c >= 0; })
+                       != static_cast<long>(levels * NUM_FIELDS)) {
+        throw std::runtime_error("Incomplete book columns in " + filename);
+    }
+
+    timestamps.clear();
+    columns.assign(levels * NUM_FIELDS, std::vector<double>());
+    std::vector<double> values(targets.size());
+
+    while (std::getline(filestream, line)) {
+        const char* cursor = line.c_str();
+        char* end = nullptr;
+        long long id = std::strtoll(cursor, &end, 10);
+        if (end == cursor || *end != ',') {
+            LOG(WARNING) << "Skipping malformed line: " << line;
+            continue;  // Skip malformed lines
+        }
+
+        size_t count = 0;
+        cursor = end;
+        while (*cursor == ',' && count <= values.size()) {
+            double value = std::strtod(cursor + 1, &end);
+            if (end == cursor + 1) break;
+            if (count < values.size()) values[count] = value;
+            ++count;
+            cursor = end;
+        }
+
+        if (count != targets.size()) {
+            LOG(WARNING) << "Skipping malformed line: " << line;
+            continue;  // Skip malformed lines
+        }
+
+        timestamps.push_back(id);
+        for (size_t ii = 0; ii < targets.size(); ++ii) {
+            if (targets[ii] >= 0) columns[targets[ii]].push_back(values[ii]);
+        }
+    }
+}
+
+TickFileSummary TickConverter::convert(const std::string& csv_file, const std::string& tick_file) {
+    size_t levels = 0;
+    std::vector<long long> timestamps;
+    std::vector<std::vector<double>> columns;
+    readCsv(csv_file, levels, timestamps, columns);
+    auto extension = fs::path(tick_file).extension();
+    if (extension == ".blk") {
+        BlockFile::write(tick_file, levels, timestamps, columns);
+    } else if (extension == ".dlt") {
+        DeltaFile::write(tick_file, levels, timestamps, columns);
+    } else {
+        TickFile::write(tick_file, levels, timestamps, columns);
+    }
+
+    TickFileSummary summary;
+    summary.filename = fs::path(tick_file).filename().string();
+    summary.rows = timestamps.size();
+    if (!timestamps.empty()) {
+        summary.first_timestamp = timestamps.front();
+        summary.last_timestamp = timestamps.back();
+    }
+    return summary;
+}
+
+std::vector<TickFileSummary> TickConverter::convertFolder(const std::string& input_folder,
+                                                          const std::string& output_folder,
+                                                          size_t num_threads,
+                                                          const std::string& extension) {
+    std::vector<fs::path> inputs;
+    for (const auto& entry : fs::directory_iterator(input_folder)) {
+        if (entry.is_regular_file() && entry.path().extension() == ".csv") {
+            inputs.push_back(entry.path());
+        }
+    }
+    std::sort(inputs.begin(), inputs.end());
+    fs::create_directories(output_folder);
+
+    std::vector<TickFileSummary> summaries(inputs.size());
+    std::vector<std::string> errors(inputs.size());
+    std::atomic<size_t> next_file(0);
+    auto worker = [&]() {
+        for (size_t idx = next_file++; idx < inputs.size(); idx = next_file++) {
+            auto output = fs::path(output_folder) / inputs[idx].stem();
+            output += extension;
+            try {
+                summaries[idx] = convert(inputs[idx].string(), output.string());
+            } catch (const std::exception& e) {
+                errors[idx] = e.what();
+            }
+        }
+    };
+
+    std::vector<std::thread> workers;
+    num_threads = std::max<size_t>(1, std::min(num_threads, inputs.size()));
+    for (size_t ii = 0; ii < num_threads; ++ii) {
+        workers.emplace_back(worker);
+    }
+    for (auto& thread : workers) {
+        thread.join();
+    }
+
+    for (size_t idx = 0; idx < inputs.size(); ++idx) {
+        if (!errors[idx].empty()) {
+            throw std::runtime_error("Error converting " + inputs[idx].string() + ": " + errors[idx]);
+        }
+    }
+
+    writeManifest((fs::path(output_folder) / MANIFEST).string(), summaries);
+    return summaries;
+}
+
+void TickConverter::writeManifest(const std::string& filename, const std::vector<TickFileSummary>& summaries) {
+    std::ofstream out(filename, std::ios::trunc);
+    if (!out.is_open()) {
+        throw std::runtime_error("Could not create manifest " + filename);
+    }
+
+    out << "filename,rows,first_timestamp,last_timestamp\n";
+    for (const auto& summary : summaries) {
+        out << summary.filename << ',' << summary.rows << ','
+            << summary.first_timestamp << ',' << summary.last_timestamp << '\n';
+    }
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include <string>
+#include <vector>
+#include "block_file.h"
+#include "delta_file.h"
+#include "tick_file.h"
+
+namespace RLTrader {
+    // Row index entry written to the manifest for every converted file
+    struct TickFileSummary {
+        std::string filename;
+        size_t rows = 0;
+        long long first_timestamp = 0;
+        long long last_timestamp = 0;
+    };
+
+    class TickConverter {
+    public:
+        // Folder level row index, each tick file already addresses its rows by position and carries its
+        // timestamp column, so the manifest only adds the row counts and time ranges the catalog needs
+        static constexpr const char* MANIFEST = "manifest.csv";
+
+        // Parses a book csv into a timestamp column and levels * NUM_FIELDS value columns
+        static void readCsv(const std::string& filename, size_t& levels,
+                            std::vector<long long>& timestamps,
+                            std::vector<std::vector<double>>& columns);
+
+        // Converts one csv file into a tick file, a block compressed one (.blk) or a delta encoded one (.dlt)
+        static TickFileSummary convert(const std::string& csv_file, const std::string& tick_file);
+
+        // Converts every csv in a folder to extension files using num_threads workers and writes the manifest
+        static std::vector<TickFileSummary> convertFolder(const std::string& input_folder,
+                                                          const std::string& output_folder,
+                                                          size_t num_threads,
+                                                          const std::string& extension = ".bin");
+
+        static void writeManifest(const std::string& filename, const std::vector<TickFileSummary>& summaries);
+    };
+}
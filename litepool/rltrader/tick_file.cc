@@ -0,0 +1,134 @@
+#include "tick_file.h"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "orderbook.h"
+
+using namespace RLTrader;
+
+TickFile::TickFile(const std::string& filename) {
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Could not open tick file " + filename);
+    }
+
+    struct stat st{};
+    if (::fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(TickFileHeader)) {
+        ::close(fd);
+        throw std::runtime_error("Invalid tick file " + filename);
+    }
+
+    mapping_size = static_cast<size_t>(st.st_size);
+    mapping = ::mmap(nullptr, mapping_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+
+    if (mapping == MAP_FAILED) {
+        mapping = nullptr;
+        throw std::runtime_error("Could not map tick file " + filename);
+    }
+
+    const auto* header = static_cast<const TickFileHeader*>(mapping);
+    num_rows = header->rows;
+    num_levels = header->levels;
+    size_t expected = sizeof(TickFileHeader) + num_rows * sizeof(long long)
+                      + num_levels * NUM_FIELDS * num_rows * sizeof(double);
+
+    if (std::memcmp(header->magic, MAGIC, sizeof(MAGIC)) != 0
+        || header->version != VERSION
+        || expected != mapping_size) {
+        ::munmap(mapping, mapping_size);
+        mapping = nullptr;
+        throw std::runtime_error("Corrupt tick file " + filename);
+    }
+
+    const char* base = static_cast<const char*>(mapping) + sizeof(TickFileHeader);
+    timestamp_column = reinterpret_cast<const long long*>(base);
+    value_columns = reinterpret_cast<const double*>(base + num_rows * sizeof(long long));
+    ::madvise(mapping, mapping_size, MADV_WILLNEED);
+}
+
+TickFile::TickFile(size_t levels, std::vector<long long> timestamps, const std::vector<std::vector<double>>& columns)
+    :num_rows(timestamps.size()), num_levels(levels), owned_timestamps(std::move(timestamps)) {
+    if (columns.size() != levels * NUM_FIELDS) {
+        throw std::runtime_error("Column count does not match levels");
+    }
+
+    owned_values.reserve(columns.size() * num_rows);
+    for (const auto& column : columns) {
+        if (column.size() != num_rows) {
+            throw std::runtime_error("Column length does not match timestamps");
+        }
+        owned_values.insert(owned_values.end(), column.begin(), column.end());
+    }
+
+    timestamp_column = owned_timestamps.data();
+    value_columns = owned_values.data();
+}
+
+int TickFile::columnOf(const std::string& header) {
+    int level = 0;
+    char side[5] = {};
+    char field[7] = {};
+    if (std::sscanf(header.c_str(), "%4[a-z][%d].%6[a-z]", side, &level, field) != 3
+        || level < 0 || level >= static_cast<int>(OrderBook::MAX_LEVELS)) {
+        return -1;
+    }
+
+    std::string side_name(side);
+    std::string field_name(field);
+    int offset = -1;
+    if (side_name == "asks" && field_name == "price") offset = ASK_PRICE;
+    else if (side_name == "asks" && field_name == "amount") offset = ASK_AMOUNT;
+    else if (side_name == "bids" && field_name == "price") offset = BID_PRICE;
+    else if (side_name == "bids" && field_name == "amount") offset = BID_AMOUNT;
+    return offset < 0 ? -1 : level * NUM_FIELDS + offset;
+}
+
+TickFile::~TickFile() {
+    if (mapping != nullptr) {
+        ::munmap(mapping, mapping_size);
+    }
+}
+
+void TickFile::write(const std::string& filename, size_t levels,
+                     const std::vector<long long>& timestamps,
+                     const std::vector<std::vector<double>>& columns) {
+    if (columns.size() != levels * NUM_FIELDS) {
+        throw std::runtime_error("Column count does not match levels");
+    }
+
+    for (const auto& column : columns) {
+        if (column.size() != timestamps.size()) {
+            throw std::runtime_error("Column length does not match timestamps");
+        }
+    }
+
+    std::ofstream out(filename, std::ios::binary | std::ios::trunc);
+    if (!out.is_open()) {
+        throw std::runtime_error("Could not create tick file " + filename);
+    }
+
+    TickFileHeader header{};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.levels = static_cast<uint32_t>(levels);
+    header.rows = timestamps.size();
+
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(timestamps.data()),
+              static_cast<std::streamsize>(timestamps.size() * sizeof(long long)));
+
+    for (const auto& column : columns) {
+        out.write(reinterpret_cast<const char*>(column.data()),
+                  static_cast<std::streamsize>(column.size() * sizeof(double)));
+    }
+
+    if (!out.good()) {
+        throw std::runtime_error("Failed writing tick file " + filename);
+    }
+}
@@ -0,0 +1,66 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace RLTrader {
+    // per level column order, same as the csv files
+    enum TickField {
+        ASK_PRICE = 0,
+        ASK_AMOUNT = 1,
+        BID_PRICE = 2,
+        BID_AMOUNT = 3,
+        NUM_FIELDS = 4
+    };
+
+    // On-disk layout: header, timestamp column, then one double column per (level, field)
+    struct TickFileHeader {
+        char magic[8];
+        uint32_t version;
+        uint32_t levels;
+        uint64_t rows;
+        uint64_t reserved;
+    };
+
+    class TickFile {
+    public:
+        static constexpr char MAGIC[8] = {'L', 'P', 'T', 'I', 'C', 'K', '0', '1'};
+        static constexpr uint32_t VERSION = 1;
+
+        // Maps the file read-only into memory
+        explicit TickFile(const std::string& filename);
+
+        // Holds already parsed columns in memory
+        TickFile(size_t levels, std::vector<long long> timestamps, const std::vector<std::vector<double>>& columns);
+        ~TickFile();
+
+        TickFile(const TickFile&) = delete;
+        TickFile& operator=(const TickFile&) = delete;
+
+        [[nodiscard]] size_t rows() const { return num_rows; }
+        [[nodiscard]] size_t levels() const { return num_levels; }
+        [[nodiscard]] const long long* timestamps() const { return timestamp_column; }
+
+        [[nodiscard]] const double* column(size_t level, TickField field) const {
+            return value_columns + (level * NUM_FIELDS + field) * num_rows;
+        }
+
+        // Column of a csv header such as "bids[3].amount" in the tick layout, -1 if it is not a book column
+        static int columnOf(const std::string& header);
+
+        // Writes columns (levels * NUM_FIELDS of them, each timestamps.size() long) to a tick file
+        static void write(const std::string& filename, size_t levels,
+                          const std::vector<long long>& timestamps,
+                          const std::vector<std::vector<double>>& columns);
+
+    private:
+        void* mapping = nullptr;
+        size_t mapping_size = 0;
+        size_t num_rows = 0;
+        size_t num_levels = 0;
+        const long long* timestamp_column = nullptr;
+        const double* value_columns = nullptr;
+        std::vector<long long> owned_timestamps;
+        std::vector<double> owned_values;
+    };
+}
@@ -0,0 +1,66 @@
+#include "tick_reader.h"
+#include <algorithm>
+#include <stdexcept>
+
+using namespace RLTrader;
+
+TickReader::TickReader(const std::string& filename, int start_read_rows, int max_read_rows)
+    :TickReader(std::make_shared<const TickFile>(filename), start_read_rows, max_read_rows) {
+}
+
+TickReader::TickReader(std::shared_ptr<const TickFile> data, int start_read_rows, int max_read_rows)
+    :file(std::move(data)),
+     bid_prices(file->column(0, BID_PRICE)),
+     ask_prices(file->column(0, ASK_PRICE)),
+     book_levels(std::min(file->levels(), OrderBook::MAX_LEVELS)),
+     start_read(start_read_rows), max_read(max_read_rows) {
+    if (file->levels() == 0) {
+        throw std::runtime_error("Tick file has no book levels");
+    }
+}
+
+void TickReader::reset() {
+    this->seek(randomStart(start_read));
+}
+
+void TickReader::seek(size_t start_row) {
+    if (start_row >= file->rows()) {
+        throw std::runtime_error("Failed to skip to start line");
+    }
+
+    next_row = start_row;
+    end_row = std::min(file->rows(), start_row + static_cast<size_t>(max_read) + 1);
+    this->advance();
+}
+
+size_t TickReader::rowAt(long long timestamp) {
+    const long long* first = file->timestamps();
+    auto row = static_cast<size_t>(std::lower_bound(first, first + file->rows(), timestamp) - first);
+    return std::min(row, file->rows() - 1);
+}
+
+void TickReader::advance() {
+    if (!hasNext()) {
+        throw std::out_of_range("No more elements");
+    }
+    current_row = next_row++;
+}
+
+size_t TickReader::skip(size_t rows) {
+    size_t moved = std::min(rows, end_row - next_row);
+    if (moved > 0) {
+        next_row += moved;
+        current_row = next_row - 1;
+    }
+    return moved;
+}
+
+void TickReader::toBook(OrderBook& book) const {
+    for (size_t level = 0; level < book_levels; ++level) {
+        book.ask_prices[level] = file->column(level, ASK_PRICE)[current_row];
+        book.ask_sizes[level] = file->column(level, ASK_AMOUNT)[current_row];
+        book.bid_prices[level] = file->column(level, BID_PRICE)[current_row];
+        book.bid_sizes[level] = file->column(level, BID_AMOUNT)[current_row];
+    }
+    book.clearFrom(book_levels);
+}
@@ -0,0 +1,49 @@
+#pragma once
+#include <memory>
+#include <string>
+#include "base_reader.h"
+#include "tick_file.h"
+
+namespace RLTrader {
+    class TickReader final : public BaseReader {
+    public:
+        TickReader(const std::string& filename, int start_read, int max_read);
+
+        // Replays tick data shared with other readers
+        TickReader(std::shared_ptr<const TickFile> data, int start_read, int max_read);
+
+        void reset() override;
+
+        void seek(size_t start_row) override;
+
+        [[nodiscard]] size_t rowAt(long long timestamp) override;
+
+        bool hasNext() override { return next_row < end_row; }
+
+        void advance() override;
+
+        // Columns are in memory, so skipping only moves the row
+        size_t skip(size_t rows) override;
+
+        [[nodiscard]] size_t getRow() const override { return current_row; }
+
+        [[nodiscard]] long long getTimeStamp() const override { return file->timestamps()[current_row]; }
+
+        [[nodiscard]] double getBestBidPrice() const override { return bid_prices[current_row]; }
+
+        [[nodiscard]] double getBestAskPrice() const override { return ask_prices[current_row]; }
+
+        void toBook(OrderBook& book) const override;
+
+    private:
+        std::shared_ptr<const TickFile> file;
+        const double* bid_prices;
+        const double* ask_prices;
+        size_t book_levels;
+        int start_read;
+        int max_read;
+        size_t current_row = 0;
+        size_t next_row = 0;
+        size_t end_row = 0;
+    };
+}
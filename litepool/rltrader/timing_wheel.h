@@ -0,0 +1,174 @@
+#pragma once
+#include <algorithm>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+#include "ring_queue.h"
+
+namespace RLTrader {
+    // Hashed timing wheel, scheduling is O(1) and releasing walks only the buckets the clock passed.
+    // Entries live in a node pool that is reused, so steady state scheduling does not allocate.
+    template <typename T>
+    class TimingWheel {
+    public:
+        // slots is rounded up to a power of two, resolution is the width of a bucket in timestamp units
+        explicit TimingWheel(size_t slots = 256, long long resolution = 128, size_t initial_nodes = 256)
+            :resolution(resolution), free_nodes(initial_nodes) {
+            if (resolution <= 0) {
+                throw std::runtime_error("Timing wheel resolution must be positive");
+            }
+
+            size_t capacity = 1;
+            while (capacity < slots) capacity <<= 1;
+            heads.assign(capacity, NIL);
+            tails.assign(capacity, NIL);
+            nodes.reserve(initial_nodes);
+            released.reserve(initial_nodes);
+        }
+
+        [[nodiscard]] size_t size() const { return count; }
+        [[nodiscard]] bool empty() const { return count == 0; }
+
+        // Schedules value to come due at timestamp due, a due time already passed comes due on the next release
+        void schedule(long long due, const T& value) {
+            long long bucket = due / resolution;
+            if (cursor != NONE && bucket < cursor) bucket = cursor;
+
+            size_t node = allocate();
+            nodes[node].due = due;
+            nodes[node].sequence = scheduled++;
+            nodes[node].value = value;
+            nodes[node].next = NIL;
+
+            size_t slot = static_cast<size_t>(bucket) & (heads.size() - 1);
+            if (tails[slot] == NIL) heads[slot] = node;
+            else nodes[tails[slot]].next = node;
+            tails[slot] = node;
+            ++count;
+        }
+
+        // Calls fn on every value due by now in due order, values due at the same time in scheduling order.
+        // fn must not schedule into this wheel.
+        template <typename F>
+        void release(long long now, F&& fn) {
+            long long last = now / resolution;
+            if (cursor != NONE && last < cursor) return;
+
+            // the first release, or one past a full rotation, looks at every slot once
+            auto rotation = static_cast<long long>(heads.size());
+            long long first = cursor == NONE ? last - rotation + 1 : cursor;
+            long long walks = std::min<long long>(last - first + 1, rotation);
+            for (long long ii = 0; ii < walks; ++ii) {
+                collectSlot(static_cast<size_t>(last - walks + 1 + ii) & (heads.size() - 1), now);
+            }
+
+            // a slot walked once can hold values from several rotations, and the cursor bucket values
+            // scheduled late, so what came due is put in due then scheduling order before it is handed out,
+            // sorted in place on both keys since a stable sort takes a buffer
+            std::sort(released.begin(), released.end(), [this](size_t lhs, size_t rhs) {
+                return nodes[lhs].due != nodes[rhs].due ? nodes[lhs].due < nodes[rhs].due
+                                                        : nodes[lhs].sequence < nodes[rhs].sequence;
+            });
+            for (size_t node : released) {
+                fn(nodes[node].value);
+                free_nodes.push(node);
+                --count;
+            }
+            released.clear();
+
+            // the current bucket may still hold values due later in it
+            cursor = last;
+        }
+
+        // Visits every pending value
+        template <typename F>
+        void forEach(F&& fn) const {
+            for (size_t head : heads) {
+                for (size_t node = head; node != NIL; node = nodes[node].next) {
+                    fn(nodes[node].value);
+                }
+            }
+        }
+
+        // Visits every pending value with its due time, slot by slot and in scheduling order within a slot
+        template <typename F>
+        void forEachScheduled(F&& fn) const {
+            for (size_t head : heads) {
+                for (size_t node = head; node != NIL; node = nodes[node].next) {
+                    fn(nodes[node].due, nodes[node].value);
+                }
+            }
+        }
+
+        // Bucket of the last release, to hand to restart
+        [[nodiscard]] long long releasedBucket() const { return cursor; }
+
+        // Empties the wheel as if bucket was the last released, scheduling what
+        // forEachScheduled visited in visiting order then rebuilds the same wheel
+        void restart(long long bucket) {
+            clear();
+            cursor = bucket;
+        }
+
+        void clear() {
+            heads.assign(heads.size(), NIL);
+            tails.assign(tails.size(), NIL);
+            nodes.clear();
+            free_nodes.clear();
+            count = 0;
+            scheduled = 0;
+            cursor = NONE;
+        }
+
+    private:
+        static constexpr size_t NIL = SIZE_MAX;
+        static constexpr long long NONE = LLONG_MIN;
+
+        struct Node {
+            long long due = 0;
+            unsigned long long sequence = 0;  // order it was scheduled in
+            T value{};
+            size_t next = NIL;
+        };
+
+        size_t allocate() {
+            if (!free_nodes.empty()) {
+                size_t node = free_nodes.front();
+                free_nodes.pop();
+                return node;
+            }
+            nodes.emplace_back();
+            return nodes.size() - 1;
+        }
+
+        // Unlinks the values of a slot due by now into released
+        void collectSlot(size_t slot, long long now) {
+            size_t previous = NIL;
+            size_t node = heads[slot];
+            while (node != NIL) {
+                size_t next = nodes[node].next;
+                if (nodes[node].due <= now) {
+                    if (previous == NIL) heads[slot] = next;
+                    else nodes[previous].next = next;
+                    if (tails[slot] == node) tails[slot] = previous;
+                    released.push_back(node);
+                } else {
+                    previous = node;
+                }
+                node = next;
+            }
+        }
+
+        long long resolution;
+        std::vector<size_t> heads;
+        std::vector<size_t> tails;
+        std::vector<Node> nodes;
+        RingQueue<size_t> free_nodes;
+        std::vector<size_t> released;  // nodes that came due in a release, reused across releases
+        size_t count = 0;
+        unsigned long long scheduled = 0;  // values scheduled since the last clear
+        long long cursor = NONE;  // bucket of the last release, earlier due times are scheduled into it
+    };
+}
@@ -10,6 +10,16 @@ TradeSignalBuilder::TradeSignalBuilder()
 }
 
 
+void TradeSignalBuilder::snapshot(Snapshot& snap) const {
+    snap.previous_signals = *raw_previous_signals;
+    snap.spread_signals = *raw_spread_signals;
+}
+
+void TradeSignalBuilder::restore(const Snapshot& snap) {
+    *raw_previous_signals = snap.previous_signals;
+    *raw_spread_signals = snap.spread_signals;
+}
+
 void TradeSignalBuilder::compute_trade_signals(const TradeInfo& info, const double& bid_price, const double& ask_price) {
     trade_signal_repository repo;
     trade_signal_repository& previous_repo = *raw_previous_signals;
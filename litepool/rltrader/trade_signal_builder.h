@@ -15,10 +15,19 @@ namespace RLTrader {
 
     class TradeSignalBuilder {
         public:
+            struct Snapshot {
+                trade_signal_repository previous_signals;
+                trade_signal_repository spread_signals;
+            };
+
             TradeSignalBuilder();
 
             std::vector<double> add_trade(const TradeInfo& info, const double& bid_price, const double& ask_price);
 
+            void snapshot(Snapshot& snap) const;
+
+            void restore(const Snapshot& snap);
+
         private:
             void compute_trade_signals(const TradeInfo& info, const double& bid_price, const double& ask_price);
             std::unique_ptr<trade_signal_repository> raw_previous_signals;
@@ -0,0 +1,125 @@
+#include "trade_tape.h"
+#include <algorithm>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <glog/logging.h>
+
+using namespace RLTrader;
+namespace fs = std::filesystem;
+
+std::mutex TradeTape::mutex;
+std::unordered_map<std::string, std::shared_ptr<TradeTape::Entry>> TradeTape::entries;
+
+TradeTape::TradeTape(const std::string& filename) {
+    std::ifstream in(filename);
+    if (!in.is_open()) {
+        throw std::runtime_error("Could not open trades file " + filename);
+    }
+
+    std::string line;
+    if (!std::getline(in, line)) {
+        throw std::runtime_error("Failed to read header line");
+    }
+
+    int timestamp_column = -1;
+    int exchange_timestamp_column = -1;
+    int side_column = -1;
+    int price_column = -1;
+    int amount_column = -1;
+    std::istringstream headerStream(line);
+    std::string header;
+    for (int column = 0; std::getline(headerStream, header, ','); ++column) {
+        if (!header.empty() && header.back() == '\r') header.pop_back();
+        if (header == "local_timestamp") timestamp_column = column;
+        else if (header == "timestamp") exchange_timestamp_column = column;
+        else if (header == "side") side_column = column;
+        else if (header == "price") price_column = column;
+        else if (header == "amount") amount_column = column;
+    }
+
+    // books are stamped with the local clock, prefer it for trades too
+    if (timestamp_column < 0) timestamp_column = exchange_timestamp_column;
+    if (timestamp_column < 0 || side_column < 0 || price_column < 0 || amount_column < 0) {
+        throw std::runtime_error("Trades file needs timestamp, side, price and amount columns " + filename);
+    }
+
+    std::string field;
+    while (std::getline(in, line)) {
+        if (line.empty() || line == "\r") continue;
+        std::istringstream fields(line);
+        long long timestamp = 0;
+        double price = 0;
+        double amount = 0;
+        OrderSide side = OrderSide::BUY;
+        int parsed = 0;  // the four columns parsed so far
+        bool valid = true;
+        for (int column = 0; valid && std::getline(fields, field, ','); ++column) {
+            if (!field.empty() && field.back() == '\r') field.pop_back();
+            const char* begin = field.c_str();
+            char* end = nullptr;
+            if (column == timestamp_column) {
+                timestamp = std::strtoll(begin, &end, 10);
+            } else if (column == price_column) {
+                price = std::strtod(begin, &end);
+            } else if (column == amount_column) {
+                amount = std::strtod(begin, &end);
+            } else if (column == side_column) {
+                valid = field == "buy" || field == "sell";
+                side = field == "sell" ? OrderSide::SELL : OrderSide::BUY;
+                ++parsed;
+                continue;
+            } else {
+                continue;
+            }
+            valid = end != begin && *end == '\0';
+            ++parsed;
+        }
+
+        // a print at price 0 would cross every resting bid, so short lines and non-positive prints are dropped
+        if (!valid || parsed != 4 || !(price > 0) || !(amount > 0)) {
+            LOG(WARNING) << "Skipping malformed line: " << line;
+            continue;  // Skip malformed lines
+        }
+        timestamps.push_back(timestamp);
+        prices.push_back(price);
+        amounts.push_back(amount);
+        sides.push_back(side);
+    }
+
+    if (!std::is_sorted(timestamps.begin(), timestamps.end())) {
+        throw std::runtime_error("Trades are not in time order " + filename);
+    }
+}
+
+std::shared_ptr<const TradeTape> TradeTape::get(const std::string& filename) {
+    std::string key = fs::weakly_canonical(fs::absolute(filename)).string();
+    std::shared_ptr<Entry> entry;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto& slot = entries[key];
+        if (!slot) {
+            slot = std::make_shared<Entry>();
+        }
+        entry = slot;
+    }
+
+    // tapes of different files load in parallel, a file's tape loads once
+    std::lock_guard<std::mutex> lock(entry->mutex);
+    auto tape = entry->tape.lock();
+    if (!tape) {
+        tape = std::make_shared<const TradeTape>(key);
+        entry->tape = tape;
+    }
+    return tape;
+}
+
+std::string TradeTape::tradeFile(const std::string& book_file) {
+    return fs::path(book_file).replace_extension(".trades").string();
+}
+
+size_t TradeTape::after(long long timestamp) const {
+    return static_cast<size_t>(std::upper_bound(timestamps.begin(), timestamps.end(), timestamp) - timestamps.begin());
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "order.h"
+
+namespace RLTrader {
+    // Prints of a trades csv held as columns, side is the aggressor side
+    class TradeTape {
+    public:
+        // Reads a csv with local_timestamp (or timestamp), side, price and amount columns, skipping lines with a
+        // missing or unparsable field, a side other than buy or sell, or a non-positive price or amount
+        explicit TradeTape(const std::string& filename);
+
+        // Returns the tape of a file, loaded once per process and shared by every env
+        static std::shared_ptr<const TradeTape> get(const std::string& filename);
+
+        // Trades of a replay file live next to it with the extension replaced by .trades
+        static std::string tradeFile(const std::string& book_file);
+
+        [[nodiscard]] size_t size() const { return timestamps.size(); }
+
+        [[nodiscard]] long long timestamp(size_t ii) const { return timestamps[ii]; }
+
+        [[nodiscard]] double price(size_t ii) const { return prices[ii]; }
+
+        [[nodiscard]] double amount(size_t ii) const { return amounts[ii]; }
+
+        [[nodiscard]] OrderSide side(size_t ii) const { return sides[ii]; }
+
+        // First trade printed after timestamp
+        [[nodiscard]] size_t after(long long timestamp) const;
+
+    private:
+        struct Entry {
+            std::mutex mutex;
+            std::weak_ptr<const TradeTape> tape;
+        };
+
+        std::vector<long long> timestamps;
+        std::vector<double> prices;
+        std::vector<double> amounts;
+        std::vector<OrderSide> sides;
+
+        static std::mutex mutex;
+        static std::unordered_map<std::string, std::shared_ptr<Entry>> entries;
+    };
+}